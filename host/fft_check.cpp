@@ -0,0 +1,142 @@
+// FFT check: runs the firmware's analysis (FFT.cpp and fft_q15.cpp on the
+// esp-dsp shim) on a synthetic three-tone signal and compares each
+// backend's magnitude_bins with a direct DFT of the same windowed samples.
+// Catches anything that leaves the kernel output wrong or untouched: a
+// missing dsps_fft2r_init_*(), a bad twiddle table, a broken reorder or
+// split step.
+//
+//   fft_check            exit status 1 on a mismatch
+
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+#include "FFT.h"
+#include "fft_tables.h"
+
+// The analysis window and its spectrum, as FFT.cpp leaves them after a frame
+extern int16_t sample_history[FFT_SIZE];
+extern float magnitude_bins[FFT_SIZE / 2];
+
+// Largest error allowed, relative to the strongest bin. The Q15 path
+// estimates magnitudes to about 1.2% and rounds at every stage.
+#define FLOAT_TOLERANCE 1e-3
+#define Q15_TOLERANCE 0.03
+#define WARMUP_FRAMES 32
+
+struct tone {
+    double freq_hz;
+    double amplitude;
+};
+
+// Off-bin tones of very different levels, on an ADC-like DC offset
+static const tone kTones[] = {{437.0, 800.0}, {1210.0, 300.0}, {93.0, 150.0}};
+#define DC_OFFSET 2048
+
+static uint32_t rate_hz;
+static uint64_t sample_index;
+
+static esp_err_t tone_open(uint32_t sample_rate_hz)
+{
+    rate_hz = sample_rate_hz;
+    sample_index = 0;
+    return ESP_OK;
+}
+
+static esp_err_t tone_read_frame(int16_t *out, size_t len, uint32_t timeout_ms)
+{
+    (void)timeout_ms;
+    for (size_t i = 0; i < len; i++, sample_index++) {
+        double t = (double)sample_index / rate_hz;
+        double v = DC_OFFSET;
+        for (const tone &tn : kTones) {
+            v += tn.amplitude * sin(2.0 * M_PI * tn.freq_hz * t);
+        }
+        out[i] = (int16_t)lrint(v);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t tone_flush(void)
+{
+    return ESP_OK;
+}
+
+static esp_err_t tone_close(void)
+{
+    return ESP_OK;
+}
+
+static const audio_source_t tone_source = {
+    .name = "tones",
+    .open = tone_open,
+    .read_frame = tone_read_frame,
+    .flush = tone_flush,
+    .close = tone_close,
+    .get_stats = NULL,
+};
+
+// Largest deviation of magnitude_bins from the best-fitting multiple of a
+// direct DFT of the Hann-windowed history, relative to its strongest bin
+static double spectrum_error()
+{
+    const auto &window = fft_tables::Tables<FFT_SIZE>::hann;
+    std::vector<double> ref(FFT_SIZE / 2);
+    for (int k = 0; k < FFT_SIZE / 2; k++) {
+        double re = 0.0, im = 0.0;
+        for (int n = 0; n < FFT_SIZE; n++) {
+            double x = window[n] * sample_history[n];
+            double phase = 2.0 * M_PI * k * n / FFT_SIZE;
+            re += x * cos(phase);
+            im -= x * sin(phase);
+        }
+        ref[k] = sqrt(re * re + im * im);
+    }
+
+    // The analysis normalises by the AGC level, so only the shape is compared
+    double dot = 0.0, norm = 0.0, peak = 0.0;
+    for (int k = 0; k < FFT_SIZE / 2; k++) {
+        dot += ref[k] * magnitude_bins[k];
+        norm += ref[k] * ref[k];
+        peak = fmax(peak, ref[k]);
+    }
+    if (norm == 0.0 || dot <= 0.0) {
+        return INFINITY;
+    }
+    double scale = dot / norm;
+    double worst = 0.0;
+    for (int k = 0; k < FFT_SIZE / 2; k++) {
+        worst = fmax(worst, fabs(magnitude_bins[k] - scale * ref[k]));
+    }
+    return worst / (scale * peak);
+}
+
+static bool check_backend(fft_backend_t backend, const char *name, double tolerance)
+{
+    fft_set_backend(backend);
+    audio_frame_t frame;
+    int frames = 0;
+    for (int i = 0; i < WARMUP_FRAMES; i++) {
+        frames += fft_process_frame(&frame) ? 1 : 0;
+    }
+    if (frames != WARMUP_FRAMES) {
+        printf("%-5s: only %d of %d frames analysed\n", name, frames, WARMUP_FRAMES);
+        return false;
+    }
+    double error = spectrum_error();
+    bool ok = error <= tolerance;
+    printf("%-5s: max error %.5f of peak (limit %.3f) %s\n", name, error, tolerance, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main()
+{
+    if (!initialize_fft(&tone_source)) {
+        printf("initialize_fft failed\n");
+        return 1;
+    }
+    fft_set_window(FFT_WINDOW_HANN);
+    bool ok = check_backend(FFT_BACKEND_FLOAT, "float", FLOAT_TOLERANCE);
+    ok = check_backend(FFT_BACKEND_Q15, "q15", Q15_TOLERANCE) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+// Pitch check: sweeps synthetic tones through the firmware's analysis
+// (fft_process_frame() on the esp-dsp shim, the configured window, backend
+// and pitch settings) and measures the error of the published
+// dominant_freq. Pure tones check the sub-bin interpolation; tones with a
+// weak fundamental under louder overtones check the harmonic-product step.
+//
+// Interpolation has to do at least as well as a plain argmax on the same
+// spectrum, and no worse than an argmax on a window twice the size could
+// (half of its bin). HPS has to land within a quarter of a bin of the
+// fundamental; a wrong harmonic is off by a whole multiple of it.
+//
+//   pitch_check          exit status 1 on a failure
+
+#include <math.h>
+#include <stdio.h>
+
+#include "FFT.h"
+
+// The spectrum of the last frame, for the argmax baseline
+extern float magnitude_bins[FFT_SIZE / 2];
+
+#define TONE_STEPS 40
+#define FRAMES_PER_TONE 8   // Two windows at the default hop, so the DC filter and AGC have settled
+#define DC_OFFSET 2048
+#define TONE_AMPLITUDE 800.0
+
+static uint32_t rate_hz;
+static uint64_t sample_index;
+static double tone_hz;
+static bool harmonic_tone;
+
+static esp_err_t tone_open(uint32_t sample_rate_hz)
+{
+    rate_hz = sample_rate_hz;
+    sample_index = 0;
+    return ESP_OK;
+}
+
+static esp_err_t tone_read_frame(int16_t *out, size_t len, uint32_t timeout_ms)
+{
+    (void)timeout_ms;
+    for (size_t i = 0; i < len; i++, sample_index++) {
+        double t = 2.0 * M_PI * tone_hz * sample_index / rate_hz;
+        double v = harmonic_tone ? 0.5 * sin(t) + 1.0 * sin(2.0 * t) + 0.6 * sin(3.0 * t) : sin(t);
+        out[i] = (int16_t)lrint(DC_OFFSET + 0.5 * TONE_AMPLITUDE * v);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t tone_flush(void)
+{
+    sample_index = 0;
+    return ESP_OK;
+}
+
+static esp_err_t tone_close(void)
+{
+    return ESP_OK;
+}
+
+static const audio_source_t tone_source = {
+    .name = "tones",
+    .open = tone_open,
+    .read_frame = tone_read_frame,
+    .flush = tone_flush,
+    .close = tone_close,
+    .get_stats = NULL,
+};
+
+struct error_stats {
+    double sum = 0.0;
+    double worst = 0.0;
+
+    void add(double e)
+    {
+        sum += e;
+        worst = fmax(worst, e);
+    }
+    double mean() const { return sum / TONE_STEPS; }
+};
+
+// Analyses one tone from a fresh stream; false if a frame failed
+static bool run_tone(double freq_hz, bool harmonic, audio_frame_t *frame)
+{
+    tone_hz = freq_hz;
+    harmonic_tone = harmonic;
+    fft_reset_stream();
+    for (int i = 0; i < FRAMES_PER_TONE; i++) {
+        if (!fft_process_frame(frame)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool check_backend(fft_backend_t backend, const char *name)
+{
+    fft_set_backend(backend);
+    const double bin_hz = (double)SAMPLE_RATE / FFT_SIZE;
+    // Three bins above DC so the fundamental has two neighbours; the 3rd harmonic stays below Nyquist
+    const double f_lo = fmax(100.0, 3.0 * bin_hz);
+    const double f_hi = SAMPLE_RATE * 0.15;
+
+    error_stats argmax, interp, hps;
+    audio_frame_t frame;
+    for (int s = 0; s < TONE_STEPS; s++) {
+        // Off-grid frequencies so no tone lands exactly on a bin centre
+        double f = f_lo + (f_hi - f_lo) * (s + 0.37) / TONE_STEPS;
+        if (!run_tone(f, false, &frame)) {
+            printf("%-5s: analysis failed at %.1f Hz\n", name, f);
+            return false;
+        }
+        interp.add(fabs(frame.dominant_freq - f));
+        pitch_estimate_t est;
+        pitch_estimate(magnitude_bins, FFT_SIZE / 2, (float)bin_hz, PITCH_INTERP_NONE, false, &est);
+        argmax.add(fabs(est.freq_hz - f));
+
+        if (!run_tone(f, true, &frame)) {
+            printf("%-5s: analysis failed at %.1f Hz\n", name, f);
+            return false;
+        }
+        hps.add(fabs(frame.dominant_freq - f));
+    }
+
+    const double double_window_limit = bin_hz / 4;   // Half a bin of a 2 * FFT_SIZE argmax
+    const double hps_limit = bin_hz / 4;
+    bool ok = interp.mean() <= argmax.mean() && interp.worst <= argmax.worst && interp.worst <= double_window_limit;
+    ok = ok && (!FFT_PITCH_HPS || hps.worst <= hps_limit);
+
+    printf("%-5s: %d tones, %.0f-%.0f Hz, %d-point window at %d Hz\n", name, TONE_STEPS, f_lo, f_hi, FFT_SIZE,
+           SAMPLE_RATE);
+    printf("  argmax                 mean %6.2f Hz, worst %6.2f Hz\n", argmax.mean(), argmax.worst);
+    printf("  interpolated           mean %6.2f Hz, worst %6.2f Hz (limit %.2f)\n", interp.mean(), interp.worst,
+           double_window_limit);
+    printf("  %-22s mean %6.2f Hz, worst %6.2f Hz (limit %.2f)\n",
+           FFT_PITCH_HPS ? "harmonic tones, HPS" : "harmonic tones", hps.mean(), hps.worst, hps_limit);
+    printf("  %s\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main()
+{
+    if (!initialize_fft(&tone_source)) {
+        printf("initialize_fft failed\n");
+        return 1;
+    }
+    bool ok = check_backend(FFT_BACKEND_FLOAT, "float");
+    ok = check_backend(FFT_BACKEND_Q15, "q15") && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,311 @@
+// Host replay tool: streams a WAV file through the firmware's analysis and
+// colour mapping (the same FFT.cpp, filterbank, beat/pitch, AGC and
+// freq_color_mapper sources that run on the device), writes one CSV row per
+// analysis frame, and reports per-stage timing.
+//
+//   shall_replay [options] input.wav
+//
+// See host/README.md for the options and the CSV layout.
+
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+#include "FFT.h"
+#include "freq_color_mapper.h"
+#include "spectrum_kernels.h"
+#include "esp_timer.h"
+#include "wav_source.h"
+
+// Reference comparison: dominant frequency may move by half a bin, tempo by
+// BPM_TOLERANCE, levels and colour channels by the tolerance (levels are
+// normalised to 0-1); onsets must match exactly
+#define DEFAULT_TOLERANCE 0.02
+#define BPM_TOLERANCE 2.0
+#define MAX_REPORTED_MISMATCHES 10
+
+// Columns before the band levels; timing columns are never compared
+enum {
+    COL_FRAME, COL_TIME, COL_FREQ, COL_MAG, COL_ONSET, COL_BPM, COL_R, COL_G, COL_B,
+    COL_CAPTURE_US, COL_PREPROCESS_US, COL_ANALYSIS_US, COL_FEATURES_US, COL_MAP_US,
+    COL_FIRST_BAND
+};
+
+struct stage_totals {
+    double capture, preprocess, analysis, features, map;
+};
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [options] input.wav\n"
+            "  -o FILE          write per-frame CSV to FILE ('-' for stdout)\n"
+            "  -b float|q15     spectrum backend (default float)\n"
+            "  -a fft|goertzel  analyzer (default fft)\n"
+            "  -w hann|blackman analysis window (default hann)\n"
+            "  -H HOP           STFT hop in samples (default %d)\n"
+            "  -n BANDS         filterbank bands (default %d)\n"
+            "  -p PALETTE       colour palette (default spectrum)\n"
+            "  -r LOOPS         play the clip LOOPS times (timing runs)\n"
+            "  -c REF.csv       compare against a reference CSV, exit 1 on mismatch\n"
+            "  -t TOL           comparison tolerance (default %.2f)\n"
+            "  -B               also run the FFT and spectrum kernel micro-benchmarks\n"
+            "Built for FFT_SIZE %d at %d Hz.\n",
+            prog, FFT_DEFAULT_HOP, FILTERBANK_DEFAULT_BANDS, DEFAULT_TOLERANCE, FFT_SIZE, SAMPLE_RATE);
+}
+
+static double cpu_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static std::vector<std::vector<double>> load_csv(const char *path)
+{
+    std::vector<std::vector<double>> rows;
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "Cannot open reference %s\n", path);
+        return rows;
+    }
+    char line[8192];
+    bool header = true;
+    while (fgets(line, sizeof(line), f)) {
+        if (header) {
+            header = false;
+            continue;
+        }
+        std::vector<double> row;
+        for (char *tok = strtok(line, ",\n"); tok; tok = strtok(NULL, ",\n")) {
+            row.push_back(atof(tok));
+        }
+        rows.push_back(row);
+    }
+    fclose(f);
+    return rows;
+}
+
+// Returns a description of the first field outside tolerance, or "" if the row matches
+static std::string compare_row(const std::vector<double> &ref, const std::vector<double> &got, double tol)
+{
+    const double bin_hz = (double)SAMPLE_RATE / FFT_SIZE;
+    char msg[128];
+    if (ref.size() != got.size()) {
+        snprintf(msg, sizeof(msg), "%zu columns, expected %zu", got.size(), ref.size());
+        return msg;
+    }
+    if (fabs(ref[COL_FREQ] - got[COL_FREQ]) > bin_hz / 2) {
+        snprintf(msg, sizeof(msg), "dominant_freq %.2f, expected %.2f", got[COL_FREQ], ref[COL_FREQ]);
+        return msg;
+    }
+    if (ref[COL_ONSET] != got[COL_ONSET]) {
+        snprintf(msg, sizeof(msg), "onset %.0f, expected %.0f", got[COL_ONSET], ref[COL_ONSET]);
+        return msg;
+    }
+    if (fabs(ref[COL_BPM] - got[COL_BPM]) > BPM_TOLERANCE) {
+        snprintf(msg, sizeof(msg), "bpm %.1f, expected %.1f", got[COL_BPM], ref[COL_BPM]);
+        return msg;
+    }
+    if (fabs(ref[COL_MAG] - got[COL_MAG]) > tol) {
+        snprintf(msg, sizeof(msg), "magnitude %.4f, expected %.4f", got[COL_MAG], ref[COL_MAG]);
+        return msg;
+    }
+    for (int c = COL_R; c <= COL_B; c++) {
+        if (fabs(ref[c] - got[c]) > tol * 255) {
+            snprintf(msg, sizeof(msg), "rgb channel %d is %.0f, expected %.0f", c - COL_R, got[c], ref[c]);
+            return msg;
+        }
+    }
+    for (size_t c = COL_FIRST_BAND; c < ref.size(); c++) {
+        if (fabs(ref[c] - got[c]) > tol) {
+            snprintf(msg, sizeof(msg), "band %zu is %.4f, expected %.4f", c - COL_FIRST_BAND, got[c], ref[c]);
+            return msg;
+        }
+    }
+    return "";
+}
+
+int main(int argc, char **argv)
+{
+    const char *csv_path = NULL;
+    const char *ref_path = NULL;
+    double tolerance = DEFAULT_TOLERANCE;
+    fft_backend_t backend = FFT_BACKEND_FLOAT;
+    fft_analyzer_t analyzer = FFT_ANALYZER_FFT;
+    fft_window_t window = FFT_WINDOW_HANN;
+    int hop = FFT_DEFAULT_HOP;
+    int bands = FILTERBANK_DEFAULT_BANDS;
+    int loops = 1;
+    const char *palette = NULL;
+    bool bench = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "o:b:a:w:H:n:p:r:c:t:Bh")) != -1) {
+        switch (opt) {
+            case 'o': csv_path = optarg; break;
+            case 'b': backend = strcmp(optarg, "q15") == 0 ? FFT_BACKEND_Q15 : FFT_BACKEND_FLOAT; break;
+            case 'a': analyzer = strcmp(optarg, "goertzel") == 0 ? FFT_ANALYZER_GOERTZEL : FFT_ANALYZER_FFT; break;
+            case 'w': window = strcmp(optarg, "blackman") == 0 ? FFT_WINDOW_BLACKMAN : FFT_WINDOW_HANN; break;
+            case 'H': hop = atoi(optarg); break;
+            case 'n': bands = atoi(optarg); break;
+            case 'p': palette = optarg; break;
+            case 'r': loops = atoi(optarg); break;
+            case 'c': ref_path = optarg; break;
+            case 't': tolerance = atof(optarg); break;
+            case 'B': bench = true; break;
+            default: usage(argv[0]); return 2;
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (!wav_source_load(argv[optind])) {
+        return 2;
+    }
+    wav_source_set_loops(loops);
+    if (!initialize_fft(&wav_audio_source) || !fft_set_hop_size(hop) || !fft_set_band_count(bands)) {
+        fprintf(stderr, "Invalid analysis settings\n");
+        return 2;
+    }
+    fft_set_backend(backend);
+    fft_set_analyzer(analyzer);
+    fft_set_window(window);
+    if (palette && !palette_select(palette_find(palette))) {
+        fprintf(stderr, "Unknown palette %s\n", palette);
+        return 2;
+    }
+
+    FILE *csv = NULL;
+    if (csv_path) {
+        csv = strcmp(csv_path, "-") == 0 ? stdout : fopen(csv_path, "w");
+        if (!csv) {
+            fprintf(stderr, "Cannot write %s\n", csv_path);
+            return 2;
+        }
+    }
+
+    std::vector<std::vector<double>> reference;
+    if (ref_path) {
+        reference = load_csv(ref_path);
+        if (reference.empty()) {
+            return 2;
+        }
+    }
+
+    struct stage_totals totals = {};
+    uint32_t frames = 0;
+    uint32_t mismatches = 0;
+    bool header_written = false;
+    double cpu_start = cpu_seconds();
+    int64_t wall_start = esp_timer_get_time();
+
+    audio_frame_t frame;
+    uint64_t consumed = 0;
+    while (true) {
+        bool ready = fft_process_frame(&frame);
+        uint64_t pos = wav_source_position();
+        if (!ready) {
+            if (pos == consumed) {
+                break;  // Source exhausted
+            }
+            consumed = pos;
+            continue;   // Goertzel block still filling
+        }
+        consumed = pos;
+
+        int64_t map_start = esp_timer_get_time();
+        rgb_t color = map_frequency_to_color(frame.dominant_freq, frame.dominant_magnitude);
+        uint32_t map_us = (uint32_t)(esp_timer_get_time() - map_start);
+
+        totals.capture += frame.capture_us;
+        totals.preprocess += frame.preprocess_us;
+        totals.analysis += frame.analysis_us;
+        totals.features += frame.features_us;
+        totals.map += map_us;
+
+        std::vector<double> row = {
+            (double)frames, (double)pos / SAMPLE_RATE, frame.dominant_freq, frame.dominant_magnitude,
+            frame.onset ? 1.0 : 0.0, frame.bpm, (double)color.r, (double)color.g, (double)color.b,
+            (double)frame.capture_us, (double)frame.preprocess_us, (double)frame.analysis_us,
+            (double)frame.features_us, (double)map_us,
+        };
+        for (int b = 0; b < frame.band_count; b++) {
+            row.push_back(frame.bands[b]);
+        }
+
+        if (csv) {
+            if (!header_written) {
+                fprintf(csv, "frame,time_s,dominant_freq,magnitude,onset,bpm,r,g,b,"
+                             "capture_us,preprocess_us,analysis_us,features_us,map_us");
+                for (int b = 0; b < frame.band_count; b++) {
+                    fprintf(csv, ",band%d", b);
+                }
+                fprintf(csv, "\n");
+                header_written = true;
+            }
+            fprintf(csv, "%u,%.4f,%.2f,%.5f,%d,%.1f,%d,%d,%d,%u,%u,%u,%u,%u", frames, row[COL_TIME],
+                    frame.dominant_freq, frame.dominant_magnitude, frame.onset ? 1 : 0, frame.bpm,
+                    color.r, color.g, color.b, frame.capture_us, frame.preprocess_us, frame.analysis_us,
+                    frame.features_us, map_us);
+            for (int b = 0; b < frame.band_count; b++) {
+                fprintf(csv, ",%.5f", frame.bands[b]);
+            }
+            fprintf(csv, "\n");
+        }
+
+        if (ref_path && frames < reference.size()) {
+            std::string diff = compare_row(reference[frames], row, tolerance);
+            if (!diff.empty() && ++mismatches <= MAX_REPORTED_MISMATCHES) {
+                fprintf(stderr, "frame %u: %s\n", frames, diff.c_str());
+            }
+        }
+        frames++;
+    }
+
+    double cpu_s = cpu_seconds() - cpu_start;
+    double wall_s = (esp_timer_get_time() - wall_start) / 1e6;
+    if (csv && csv != stdout) {
+        fclose(csv);
+    }
+
+    double processing_us = totals.preprocess + totals.analysis + totals.features + totals.map;
+    FILE *out = (csv == stdout) ? stderr : stdout;
+    fprintf(out, "%s: %.1f s at %u Hz -> %d Hz, %u frames (FFT_SIZE %d, hop %d, %s, %s)\n", argv[optind],
+            wav_source_duration_s() * loops, wav_source_file_rate(), SAMPLE_RATE, frames, FFT_SIZE, hop,
+            backend == FFT_BACKEND_Q15 ? "q15" : "float", analyzer == FFT_ANALYZER_GOERTZEL ? "goertzel" : "fft");
+    if (frames > 0) {
+        fprintf(out, "  stage       avg us/frame\n");
+        fprintf(out, "  capture     %8.2f  (file read)\n", totals.capture / frames);
+        fprintf(out, "  preprocess  %8.2f\n", totals.preprocess / frames);
+        fprintf(out, "  analysis    %8.2f\n", totals.analysis / frames);
+        fprintf(out, "  features    %8.2f\n", totals.features / frames);
+        fprintf(out, "  colour map  %8.2f\n", totals.map / frames);
+        fprintf(out, "  %.0f frames/s per core (processing stages only), %.0f frames/s end to end "
+                "(%.3f s CPU, %.3f s wall)\n",
+                processing_us > 0 ? frames * 1e6 / processing_us : 0.0, cpu_s > 0 ? frames / cpu_s : 0.0,
+                cpu_s, wall_s);
+    }
+
+    if (bench) {
+        fft_benchmark(1000);
+        spectrum_kernels_benchmark(FFT_SIZE, 1000);
+    }
+
+    if (ref_path) {
+        if (frames != reference.size()) {
+            fprintf(stderr, "%u frames, reference has %zu\n", frames, reference.size());
+            mismatches++;
+        }
+        fprintf(out, "Reference check: %s (%u mismatching frames)\n", mismatches ? "FAILED" : "passed", mismatches);
+        return mismatches ? 1 : 0;
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""Stream mono PCM to the device's UDP audio source (CONFIG_AUDIO_SOURCE_UDP).
+
+    send_pcm.py DEVICE_IP clip.wav            # play a WAV file
+    send_pcm.py DEVICE_IP --tone 440          # synthetic tone with a 120 BPM click
+    arecord -f S16_LE -r 16000 -c 1 | send_pcm.py DEVICE_IP --raw -
+
+The rate must match CONFIG_AUDIO_SAMPLE_RATE; the device drops packets at
+any other rate. WAV input is downmixed and linearly resampled to it.
+Packets are paced in real time so the device's jitter buffer stays level.
+"""
+
+import argparse
+import array
+import math
+import socket
+import struct
+import sys
+import time
+import wave
+
+MAGIC = 0x4D435053  # "SPCM", matches UDP_PCM_MAGIC in main/udp_pcm_source.h
+MAX_SAMPLES = 640   # UDP_PCM_MAX_SAMPLES
+
+
+def load_wav(path, rate):
+    with wave.open(path, "rb") as w:
+        if w.getsampwidth() != 2:
+            sys.exit(f"{path}: only 16-bit PCM WAV is supported")
+        channels = w.getnchannels()
+        src_rate = w.getframerate()
+        data = array.array("h", w.readframes(w.getnframes()))
+    if sys.byteorder == "big":
+        data.byteswap()
+
+    mono = [sum(data[i:i + channels]) / channels for i in range(0, len(data), channels)]
+    if src_rate == rate:
+        return [int(v) for v in mono]
+
+    step = src_rate / rate
+    out = []
+    pos = 0.0
+    while pos < len(mono) - 1:
+        i = int(pos)
+        frac = pos - i
+        out.append(int(mono[i] * (1.0 - frac) + mono[i + 1] * frac))
+        pos += step
+    return out
+
+
+def tone(freq, rate, seconds=4.0):
+    out = []
+    for n in range(int(rate * seconds)):
+        t = n / rate
+        v = 0.3 * math.sin(2 * math.pi * freq * t)
+        if t % 0.5 < 0.05:  # 120 BPM kick
+            v += 0.4 * math.sin(2 * math.pi * 60 * t)
+        out.append(int(v * 32767))
+    return out
+
+
+def raw_blocks(stream, count):
+    while True:
+        chunk = stream.read(count * 2)
+        if len(chunk) < 2:
+            return
+        block = array.array("h", chunk[: len(chunk) // 2 * 2])
+        if sys.byteorder == "big":
+            block.byteswap()
+        yield block
+
+
+def clip_blocks(samples, count, loop):
+    while True:
+        for i in range(0, len(samples), count):
+            yield samples[i:i + count]
+        if not loop:
+            return
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument("host")
+    p.add_argument("wav", nargs="?", help="16-bit WAV file to play")
+    p.add_argument("--port", type=int, default=5005)
+    p.add_argument("--rate", type=int, default=4000, help="must match CONFIG_AUDIO_SAMPLE_RATE")
+    p.add_argument("--tone", type=float, help="send a synthetic tone instead of a file")
+    p.add_argument("--raw", help="read raw s16le mono at --rate from this file ('-' for stdin)")
+    p.add_argument("--packet", type=int, default=256, help=f"samples per packet (max {MAX_SAMPLES})")
+    p.add_argument("--loop", action="store_true", help="repeat the clip or tone until interrupted")
+    args = p.parse_args()
+
+    count = max(1, min(args.packet, MAX_SAMPLES))
+    if args.raw:
+        stream = sys.stdin.buffer if args.raw == "-" else open(args.raw, "rb")
+        blocks = raw_blocks(stream, count)
+        realtime = args.raw != "-"  # A live capture is already paced by the sound card
+    elif args.tone:
+        blocks = clip_blocks(tone(args.tone, args.rate), count, args.loop)
+        realtime = True
+    elif args.wav:
+        blocks = clip_blocks(load_wav(args.wav, args.rate), count, args.loop)
+        realtime = True
+    else:
+        p.error("give a WAV file, --tone or --raw")
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    seq = 0
+    sent = 0
+    start = time.monotonic()
+    try:
+        for block in blocks:
+            clamped = [max(-32768, min(32767, int(v))) for v in block]
+            packet = struct.pack("<III", MAGIC, seq & 0xFFFFFFFF, args.rate)
+            packet += struct.pack(f"<{len(clamped)}h", *clamped)
+            sock.sendto(packet, (args.host, args.port))
+            seq += 1
+            sent += len(clamped)
+            if realtime:
+                ahead = start + sent / args.rate - time.monotonic()
+                if ahead > 0:
+                    time.sleep(ahead)
+    except KeyboardInterrupt:
+        pass
+    print(f"sent {seq} packets, {sent / args.rate:.1f} s of audio", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
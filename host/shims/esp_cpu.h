@@ -0,0 +1,13 @@
+#pragma once
+// Host stand-in: there is no portable cycle counter, so "cycles" are
+// nanoseconds of the process CPU clock
+
+#include <stdint.h>
+#include <time.h>
+
+static inline uint32_t esp_cpu_get_cycle_count(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
@@ -0,0 +1,144 @@
+#include "esp_dsp.h"
+#include <math.h>
+#include <stdlib.h>
+
+float *dsps_fft_w_table_fc32 = NULL;
+int dsps_fft_w_table_size = 0;
+int16_t *dsps_fft_w_table_sc16 = NULL;
+int dsps_fft_w_table_sc16_size = 0;
+
+static int bit_reverse_index(int i, int bits)
+{
+    int r = 0;
+    for (int b = 0; b < bits; b++) {
+        r = (r << 1) | ((i >> b) & 1);
+    }
+    return r;
+}
+
+// (cos, sin) of 2*pi*i/N for i < N/2, in bit-reversed order
+static int twiddle_bits(int table_size)
+{
+    int bits = 0;
+    while ((1 << bits) < table_size / 2) {
+        bits++;
+    }
+    return bits;
+}
+
+esp_err_t dsps_fft2r_init_fc32(float *fft_table_buff, int table_size)
+{
+    if (table_size <= 0 || (table_size & (table_size - 1)) != 0) {
+        return ESP_ERR_DSP_INVALID_LENGTH;
+    }
+    if (dsps_fft_w_table_fc32) {
+        return ESP_OK;
+    }
+    float *w = fft_table_buff ? fft_table_buff : (float *)calloc(table_size, sizeof(float));
+    if (!w) {
+        return ESP_ERR_NO_MEM;
+    }
+    int bits = twiddle_bits(table_size);
+    for (int i = 0; i < table_size / 2; i++) {
+        double phase = 2.0 * M_PI * i / table_size;
+        int j = bit_reverse_index(i, bits);
+        w[2 * j] = (float)cos(phase);
+        w[2 * j + 1] = (float)sin(phase);
+    }
+    dsps_fft_w_table_fc32 = w;
+    dsps_fft_w_table_size = table_size;
+    return ESP_OK;
+}
+
+esp_err_t dsps_fft2r_init_sc16(int16_t *fft_table_buff, int table_size)
+{
+    if (table_size <= 0 || (table_size & (table_size - 1)) != 0) {
+        return ESP_ERR_DSP_INVALID_LENGTH;
+    }
+    if (dsps_fft_w_table_sc16) {
+        return ESP_OK;
+    }
+    int16_t *w = fft_table_buff ? fft_table_buff : (int16_t *)calloc(table_size, sizeof(int16_t));
+    if (!w) {
+        return ESP_ERR_NO_MEM;
+    }
+    int bits = twiddle_bits(table_size);
+    for (int i = 0; i < table_size / 2; i++) {
+        double phase = 2.0 * M_PI * i / table_size;
+        int j = bit_reverse_index(i, bits);
+        w[2 * j] = (int16_t)lround(cos(phase) * 32767.0);
+        w[2 * j + 1] = (int16_t)lround(sin(phase) * 32767.0);
+    }
+    dsps_fft_w_table_sc16 = w;
+    dsps_fft_w_table_sc16_size = table_size;
+    return ESP_OK;
+}
+
+// Same butterfly order and twiddle layout as esp-dsp's dsps_fft2r_fc32_ansi_
+esp_err_t dsps_fft2r_fc32_ansi_(float *data, int N, float *w)
+{
+    if (!dsps_fft_w_table_fc32) {
+        return ESP_ERR_DSP_UNINITIALIZED;
+    }
+    if (N > dsps_fft_w_table_size) {
+        return ESP_ERR_DSP_INVALID_LENGTH;
+    }
+    int ie = 1;
+    for (int N2 = N / 2; N2 > 0; N2 >>= 1) {
+        int ia = 0;
+        for (int j = 0; j < ie; j++) {
+            float c = w[2 * j];
+            float s = w[2 * j + 1];
+            for (int i = 0; i < N2; i++) {
+                int m = ia + N2;
+                float re_temp = c * data[2 * m] + s * data[2 * m + 1];
+                float im_temp = c * data[2 * m + 1] - s * data[2 * m];
+                data[2 * m] = data[2 * ia] - re_temp;
+                data[2 * m + 1] = data[2 * ia + 1] - im_temp;
+                data[2 * ia] = data[2 * ia] + re_temp;
+                data[2 * ia + 1] = data[2 * ia + 1] + im_temp;
+                ia++;
+            }
+            ia += N2;
+        }
+        ie <<= 1;
+    }
+    return ESP_OK;
+}
+
+// Fixed-point version: every stage halves its output (rounded), so the
+// result is the transform divided by N, like dsps_fft2r_sc16
+esp_err_t dsps_fft2r_sc16_ansi_(int16_t *data, int N, int16_t *w)
+{
+    if (!dsps_fft_w_table_sc16) {
+        return ESP_ERR_DSP_UNINITIALIZED;
+    }
+    if (N > dsps_fft_w_table_sc16_size) {
+        return ESP_ERR_DSP_INVALID_LENGTH;
+    }
+    int ie = 1;
+    for (int N2 = N / 2; N2 > 0; N2 >>= 1) {
+        int ia = 0;
+        for (int j = 0; j < ie; j++) {
+            int32_t c = w[2 * j];
+            int32_t s = w[2 * j + 1];
+            for (int i = 0; i < N2; i++) {
+                int m = ia + N2;
+                int32_t mr = data[2 * m];
+                int32_t mi = data[2 * m + 1];
+                int32_t ar = (int32_t)data[2 * ia] << 15;
+                int32_t ai = (int32_t)data[2 * ia + 1] << 15;
+                int32_t re_temp = c * mr + s * mi;
+                int32_t im_temp = c * mi - s * mr;
+                data[2 * m] = (int16_t)(((int64_t)ar - re_temp + (1 << 15)) >> 16);
+                data[2 * m + 1] = (int16_t)(((int64_t)ai - im_temp + (1 << 15)) >> 16);
+                data[2 * ia] = (int16_t)(((int64_t)ar + re_temp + (1 << 15)) >> 16);
+                data[2 * ia + 1] = (int16_t)(((int64_t)ai + im_temp + (1 << 15)) >> 16);
+                ia++;
+            }
+            ia += N2;
+        }
+        ie <<= 1;
+    }
+    return ESP_OK;
+}
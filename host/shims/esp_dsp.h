@@ -0,0 +1,32 @@
+#pragma once
+// Host stand-in for esp-dsp: the portable (ANSI) radix-2 kernels only.
+// Like the real library, the kernels refuse to run (ESP_ERR_DSP_UNINITIALIZED)
+// until dsps_fft2r_init_fc32/sc16() has built the twiddle table.
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_ERR_DSP_BASE 0x70000
+#define ESP_ERR_DSP_INVALID_LENGTH (ESP_ERR_DSP_BASE + 0x1)
+#define ESP_ERR_DSP_INVALID_PARAM (ESP_ERR_DSP_BASE + 0x2)
+#define ESP_ERR_DSP_PARAM_OUTOFRANGE (ESP_ERR_DSP_BASE + 0x3)
+#define ESP_ERR_DSP_UNINITIALIZED (ESP_ERR_DSP_BASE + 0x4)
+
+extern float *dsps_fft_w_table_fc32;
+extern int dsps_fft_w_table_size;
+extern int16_t *dsps_fft_w_table_sc16;
+extern int dsps_fft_w_table_sc16_size;
+
+esp_err_t dsps_fft2r_init_fc32(float *fft_table_buff, int table_size);
+esp_err_t dsps_fft2r_init_sc16(int16_t *fft_table_buff, int table_size);
+
+esp_err_t dsps_fft2r_fc32_ansi_(float *data, int N, float *w);
+esp_err_t dsps_fft2r_sc16_ansi_(int16_t *data, int N, int16_t *w);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,11 @@
+#pragma once
+// Host stand-in: the replay tool runs the analysis on one thread, so the
+// spinlocks guarding state shared with other tasks on the device are no-ops
+
+typedef struct {
+    int unused;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define taskENTER_CRITICAL(mux) ((void)(mux))
+#define taskEXIT_CRITICAL(mux) ((void)(mux))
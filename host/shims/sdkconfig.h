@@ -0,0 +1,13 @@
+#pragma once
+// Host stand-in for the generated sdkconfig.h; override with -D
+
+#ifndef CONFIG_AUDIO_FFT_SIZE
+#define CONFIG_AUDIO_FFT_SIZE 256
+#endif
+#ifndef CONFIG_AUDIO_SAMPLE_RATE
+#define CONFIG_AUDIO_SAMPLE_RATE 4000
+#endif
+#ifndef CONFIG_AUDIO_ADC_CHANNEL
+#define CONFIG_AUDIO_ADC_CHANNEL 3
+#endif
+#define CONFIG_IDF_TARGET "linux"
@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+"""Regenerate the replay regression clips (4 kHz mono s16le WAV).
+
+    host/testdata/make_clips.py host/testdata
+
+tone440.wav  4 s of a steady 440 Hz tone: no onsets, no tempo
+beat120.wav  6 s at 120 BPM: a decaying 70 Hz kick on every beat, a noise
+             hi-hat on the off-beats and a note per beat stepping through
+             an arpeggio (fixed seed, so the file is reproducible)
+
+After regenerating a clip, re-record its references (see README.md).
+"""
+import math
+import random
+import struct
+import sys
+import wave
+
+RATE = 4000
+
+
+def write_wav(path, samples):
+    with wave.open(path, 'wb') as w:
+        w.setnchannels(1)
+        w.setsampwidth(2)
+        w.setframerate(RATE)
+        w.writeframes(b''.join(struct.pack('<h', s) for s in samples))
+
+
+def tone440():
+    return [int(round(16000 * math.sin(2 * math.pi * 440 * i / RATE))) for i in range(4 * RATE)]
+
+
+def beat120():
+    duration, beat = 6.0, 0.5
+    notes = [220, 277.18, 329.63, 440, 392, 329.63, 277.18, 246.94]
+    n_total = int(RATE * duration)
+    x = [0.0] * n_total
+    rng = random.Random(1)
+    for i in range(int(duration / beat)):
+        start = int(round(i * beat * RATE))
+        for k in range(int(0.25 * RATE)):
+            if start + k < n_total:
+                t = k / RATE
+                x[start + k] += 0.6 * math.sin(2 * math.pi * 70 * t) * math.exp(-t * 18)
+        hat = start + int(beat / 2 * RATE)
+        for k in range(int(0.05 * RATE)):
+            if hat + k < n_total:
+                x[hat + k] += 0.15 * rng.gauss(0, 1) * math.exp(-k / RATE * 60)
+        f = notes[i % len(notes)]
+        for k in range(int(beat * RATE)):
+            if start + k < n_total:
+                t = k / RATE
+                x[start + k] += 0.2 * math.sin(2 * math.pi * f * t) * min(1, t * 50)
+    return [int(max(-1.0, min(1.0, v)) * 20000) for v in x]
+
+
+if __name__ == '__main__':
+    out_dir = sys.argv[1] if len(sys.argv) > 1 else '.'
+    write_wav(f'{out_dir}/tone440.wav', tone440())
+    write_wav(f'{out_dir}/beat120.wav', beat120())
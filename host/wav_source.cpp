@@ -0,0 +1,195 @@
+#include "wav_source.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// Full-scale input maps to this amplitude, matching a rail-to-rail 12-bit ADC
+#define ADC_HALF_SCALE 2047.0f
+
+static std::vector<float> file_samples;   // Mono, -1..1, at the file rate
+static uint32_t file_rate = 0;
+static std::vector<int16_t> samples;      // At the analysis rate, 12-bit swing
+static size_t read_pos = 0;
+static uint32_t loops = 1;
+static uint32_t loops_done = 0;
+static uint64_t position = 0;
+
+static uint32_t read_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t read_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+bool wav_source_load(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        data.insert(data.end(), buf, buf + n);
+    }
+    fclose(f);
+
+    if (data.size() < 12 || memcmp(data.data(), "RIFF", 4) != 0 || memcmp(data.data() + 8, "WAVE", 4) != 0) {
+        fprintf(stderr, "%s is not a RIFF/WAVE file\n", path);
+        return false;
+    }
+
+    uint16_t format = 0, channels = 0, bits = 0;
+    const uint8_t *pcm = NULL;
+    size_t pcm_len = 0;
+    for (size_t off = 12; off + 8 <= data.size();) {
+        const uint8_t *chunk = data.data() + off;
+        uint32_t len = read_u32(chunk + 4);
+        size_t avail = data.size() - off - 8;
+        if (len > avail) {
+            len = (uint32_t)avail;  // Truncated file: use what is there
+        }
+        if (memcmp(chunk, "fmt ", 4) == 0 && len >= 16) {
+            format = read_u16(chunk + 8);
+            channels = read_u16(chunk + 10);
+            file_rate = read_u32(chunk + 12);
+            bits = read_u16(chunk + 22);
+            if (format == 0xFFFE && len >= 26) {
+                format = read_u16(chunk + 32);  // WAVE_FORMAT_EXTENSIBLE: sub-format GUID starts with the tag
+            }
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            pcm = chunk + 8;
+            pcm_len = len;
+        }
+        off += 8 + len + (len & 1);
+    }
+
+    bool is_pcm16 = format == 1 && bits == 16;
+    bool is_float = format == 3 && bits == 32;
+    if (!pcm || channels == 0 || file_rate == 0 || (!is_pcm16 && !is_float)) {
+        fprintf(stderr, "%s: only 16-bit PCM and 32-bit float WAV are supported\n", path);
+        return false;
+    }
+
+    size_t frame_bytes = (size_t)channels * (bits / 8);
+    size_t frames = pcm_len / frame_bytes;
+    file_samples.assign(frames, 0.0f);
+    for (size_t i = 0; i < frames; i++) {
+        float sum = 0.0f;
+        for (int c = 0; c < channels; c++) {
+            const uint8_t *p = pcm + i * frame_bytes + c * (bits / 8);
+            if (is_pcm16) {
+                sum += (int16_t)read_u16(p) / 32768.0f;
+            } else {
+                uint32_t u = read_u32(p);
+                float v;
+                memcpy(&v, &u, sizeof(v));
+                sum += v;
+            }
+        }
+        file_samples[i] = sum / channels;
+    }
+    return true;
+}
+
+// Resample to the analysis rate: box-filter average when decimating (as the
+// ADC capture does), linear interpolation otherwise
+static esp_err_t wav_open(uint32_t sample_rate_hz)
+{
+    if (file_samples.empty()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    const double ratio = (double)file_rate / sample_rate_hz;
+    size_t out_len = (size_t)(file_samples.size() / ratio);
+    samples.assign(out_len, 0);
+
+    for (size_t n = 0; n < out_len; n++) {
+        double pos = n * ratio;
+        float v;
+        if (ratio > 1.0) {
+            size_t lo = (size_t)floor(pos);
+            size_t hi = (size_t)floor(pos + ratio);
+            if (hi > file_samples.size()) hi = file_samples.size();
+            double sum = 0.0;
+            for (size_t i = lo; i < hi; i++) sum += file_samples[i];
+            v = (float)(sum / (hi > lo ? hi - lo : 1));
+        } else {
+            size_t i = (size_t)pos;
+            float frac = (float)(pos - i);
+            float next = (i + 1 < file_samples.size()) ? file_samples[i + 1] : file_samples[i];
+            v = file_samples[i] + frac * (next - file_samples[i]);
+        }
+        float scaled = v * ADC_HALF_SCALE;
+        if (scaled > ADC_HALF_SCALE) scaled = ADC_HALF_SCALE;
+        if (scaled < -ADC_HALF_SCALE) scaled = -ADC_HALF_SCALE;
+        samples[n] = (int16_t)lrintf(scaled);
+    }
+
+    read_pos = 0;
+    loops_done = 0;
+    position = 0;
+    return ESP_OK;
+}
+
+static esp_err_t wav_read_frame(int16_t *out, size_t len, uint32_t timeout_ms)
+{
+    (void)timeout_ms;
+    for (size_t i = 0; i < len; i++) {
+        if (read_pos == samples.size()) {
+            if (++loops_done >= loops || samples.empty()) {
+                return ESP_ERR_NOT_FOUND;
+            }
+            read_pos = 0;
+        }
+        out[i] = samples[read_pos++];
+    }
+    position += len;
+    return ESP_OK;
+}
+
+static esp_err_t wav_flush(void)
+{
+    return ESP_OK;  // Nothing is buffered ahead of the reader
+}
+
+static esp_err_t wav_close(void)
+{
+    samples.clear();
+    return ESP_OK;
+}
+
+void wav_source_set_loops(uint32_t count)
+{
+    loops = count > 0 ? count : 1;
+}
+
+uint64_t wav_source_position(void)
+{
+    return position;
+}
+
+uint32_t wav_source_file_rate(void)
+{
+    return file_rate;
+}
+
+double wav_source_duration_s(void)
+{
+    return file_rate ? (double)file_samples.size() / file_rate : 0.0;
+}
+
+const audio_source_t wav_audio_source = {
+    .name = "wav",
+    .open = wav_open,
+    .read_frame = wav_read_frame,
+    .flush = wav_flush,
+    .close = wav_close,
+    .get_stats = NULL,   // Nothing to report: a file neither overruns nor drops input
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "audio_source.h"
+
+/**
+ * @brief WAV file audio source for the host replay tool
+ *
+ * The whole file is decoded up front (16-bit or 32-bit float PCM, any
+ * channel count, downmixed to mono), resampled to the rate passed to
+ * open() and scaled to the 12-bit swing of the device ADC, so the
+ * analysis sees the same numbers it would on the board.
+ */
+
+// Load a file; must be called before the source is opened
+bool wav_source_load(const char *path);
+
+// Play the file this many times back to back (default 1)
+void wav_source_set_loops(uint32_t loops);
+
+// Samples handed out so far, at the analysis rate
+uint64_t wav_source_position(void);
+
+// Original sample rate and length of the loaded file
+uint32_t wav_source_file_rate(void);
+double wav_source_duration_s(void);
+
+extern const audio_source_t wav_audio_source;
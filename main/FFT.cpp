@@ -1,116 +1,651 @@
 #include "FFT.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include "esp_timer.h"
-#include "esp_rom_sys.h"
-#include "esp_adc/adc_oneshot.h"
+#include "esp_cpu.h"
 #include "esp_dsp.h"
-#include "led_strip_control.h"
-#include "freq_color_mapper.h"
-#include "jetson_uart.h"
+#include "agc.h"
+#include "fft_q15.h"
+#include "fft_tables.h"
+#include "goertzel.h"
+#include "filterbank.h"
+#include "beat_detector.h"
+#include "pitch_estimator.h"
+#include "spectrum_kernels.h"
+#include "freertos/FreeRTOS.h"
 
-adc_oneshot_unit_handle_t adc_handle;
+// esp-dsp's radix-2 kernel for this chip. It refuses to run (returning
+// ESP_ERR_DSP_UNINITIALIZED and leaving the data alone) until
+// dsps_fft2r_init_fc32() has built dsps_fft_w_table_fc32, which it then uses.
+#if dsps_fft2r_fc32_aes3_enabled
+#define fft2r_fc32(data, n, w) dsps_fft2r_fc32_aes3_(data, n, w)
+#elif dsps_fft2r_fc32_ae32_enabled
+#define fft2r_fc32(data, n, w) dsps_fft2r_fc32_ae32_(data, n, w)
+#else
+#define fft2r_fc32(data, n, w) dsps_fft2r_fc32_ansi_(data, n, w)
+#endif
 
-// Buffers
-float complex_data[2 * FFT_SIZE];
-float magnitude_bins[FFT_SIZE / 2];
+using Tables = fft_tables::Tables<FFT_SIZE>;
 
-// Initialize FFT structures
-bool initialize_fft() {
-    esp_err_t ret = dsps_fft2r_init_fc32(NULL, FFT_SIZE);
+// Where samples come from, set by initialize_fft()
+static const audio_source_t *source = NULL;
+
+// Buffers, 16-byte aligned for the esp-dsp vector kernels
+alignas(16) int16_t sample_history[FFT_SIZE];   // Most recent FFT_SIZE samples, oldest first
+alignas(16) float complex_data[FFT_SIZE];       // FFT_SIZE real samples packed as FFT_SIZE/2 complex values
+alignas(16) int16_t complex_q15[FFT_SIZE];      // Same packing for the Q15 backend, half the size
+alignas(16) float power_bins[FFT_SIZE / 2];     // Squared magnitudes (float backend only)
+alignas(16) float magnitude_bins[FFT_SIZE / 2];
+
+// esp-dsp's radix-2 twiddles for transforms up to FFT_SIZE complex points
+// (the benchmark's full complex FFT). Passed to the init calls so the
+// library fills these instead of allocating its own from the heap.
+alignas(16) static float twiddles_fc32[FFT_SIZE];
+alignas(16) static int16_t twiddles_sc16[FFT_SIZE];
+
+// Window tables live in rodata, scaled to unit coherent gain so bin
+// magnitudes stay comparable to the unwindowed transform
+static fft_window_t window_type = FFT_WINDOW_HANN;
+static const float *active_window = Tables::hann.data();
+
+static fft_backend_t active_backend = FFT_DEFAULT_BACKEND;
+static fft_analyzer_t active_analyzer = FFT_ANALYZER_FFT;
+static fft_analyzer_t running_analyzer = FFT_ANALYZER_FFT;  // Analyzer of the last frame
+
+// Goertzel frequencies waiting to be applied by the analysis task
+static float pending_goertzel_freqs[GOERTZEL_MAX_FILTERS];
+static uint8_t pending_goertzel_count = 0;
+static portMUX_TYPE goertzel_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Band levels from the filterbank, and the frame shared with other consumers
+alignas(16) static float band_levels[FILTERBANK_MAX_BANDS];
+static volatile uint8_t pending_band_count = 0;   // Applied by the analysis task
+static audio_frame_t latest_frame;
+static portMUX_TYPE frame_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// STFT state
+static uint16_t hop_size = FFT_DEFAULT_HOP;
+static uint16_t beat_frame_samples = 0;  // Samples per frame the beat detector was last configured for
+static uint16_t history_fill = 0;   // Valid samples in sample_history after a restart
+
+// Capture lateness (see audio_frame_t::late_us). The anchor is the lowest
+// arrival offset seen, creeping up by 1/2^LATENESS_ANCHOR_SHIFT of the
+// difference per read so a slow source clock doesn't read as lateness.
+#define LATENESS_ANCHOR_SHIFT 8
+static int64_t stream_samples = 0;      // Samples read since the stream (re)started
+static int64_t arrival_anchor_us = 0;
+static uint32_t pending_late_us = 0;    // Worst lateness since the last published frame
+static uint32_t pending_samples = 0;
+
+// Achieved analysis rate, measured over FRAME_RATE_WINDOW_US
+#define FRAME_RATE_WINDOW_US 1000000
+static int64_t rate_window_start = 0;
+static uint32_t rate_window_frames = 0;
+static float measured_frame_rate = 0.0f;
+
+// Analysis cost per analyzer in cycles per input sample, averaged over about
+// one second of audio so block-at-a-time Goertzel output evens out
+static uint32_t cost_cycles[2];
+static uint32_t cost_samples[2];
+static volatile float analyzer_cost[2];
+
+// Initialize analysis state and open the audio source. Windows and the
+// split/reorder tables are generated at compile time (fft_tables.h); only
+// esp-dsp's radix-2 twiddles are computed here, into the static tables above.
+bool initialize_fft(const audio_source_t *audio_source) {
+    esp_err_t ret = dsps_fft2r_init_fc32(twiddles_fc32, FFT_SIZE);
+    if (ret == ESP_OK) {
+        ret = dsps_fft2r_init_sc16(twiddles_sc16, FFT_SIZE);
+    }
     if (ret != ESP_OK) {
-        printf("FFT initialization failed with error: %d\n", ret);
+        printf("esp-dsp FFT initialization failed with error: %d\n", ret);
         return false;
     }
 
-    adc_oneshot_unit_init_cfg_t unit_cfg = {.unit_id = ADC_UNIT_1, .ulp_mode = ADC_ULP_MODE_DISABLE};
-    ESP_ERROR_CHECK(adc_oneshot_new_unit(&unit_cfg, &adc_handle));
-    adc_oneshot_chan_cfg_t chan_cfg = {
-        .atten = ADC_ATTEN_DB_11,
-        .bitwidth = ADC_BITWIDTH_12
-    };
-    ESP_ERROR_CHECK(adc_oneshot_config_channel(adc_handle, ADC_CHANNEL, &chan_cfg));
+    if (!filterbank_init(FILTERBANK_DEFAULT_BANDS, FILTERBANK_SCALE_LOG, FILTERBANK_MIN_FREQ,
+                         SAMPLE_RATE / 2.0f, FFT_SIZE / 2, (float)SAMPLE_RATE / FFT_SIZE)) {
+        printf("Filterbank initialization failed\n");
+        return false;
+    }
+
+    agc_init(SAMPLE_RATE);
+
+    fft_q15_set_window(FFT_WINDOW_HANN);
+
+    static const float goertzel_freqs[] = GOERTZEL_DEFAULT_FREQS;
+    if (!goertzel_bank_init(goertzel_freqs, sizeof(goertzel_freqs) / sizeof(goertzel_freqs[0]),
+                            SAMPLE_RATE, GOERTZEL_DEFAULT_BLOCK)) {
+        printf("Goertzel bank initialization failed\n");
+        return false;
+    }
+
+    source = audio_source;
+    ret = source->open(SAMPLE_RATE);
+    if (ret != ESP_OK) {
+        printf("Audio source '%s' failed to open with error: %d\n", source->name, ret);
+        return false;
+    }
 
     return true;
 }
 
-// Sample audio from ADC with precise timing
-static void sample_audio() {
-    int64_t start_time = esp_timer_get_time();
-    int sample_period_us = 1000000 / SAMPLE_RATE;
+const audio_source_t *fft_get_source(void) {
+    return source;
+}
 
-    for (int i = 0; i < FFT_SIZE; ++i) {
-        int64_t next_sample_time = start_time + i * sample_period_us;
+// Magnitude scale that maps a sine at the AGC level to 1.0: with the window
+// at unit coherent gain such a tone peaks at level * FFT_SIZE / 2
+static float normalization_gain() {
+    return 2.0f / (FFT_SIZE * agc_get_level());
+}
+
+// Apply the window and the normalisation gain and convert to float (the
+// samples are already offset-free). Consecutive real samples land in the
+// real/imaginary slots of the packed N/2-point complex input.
+template <size_t N>
+static void load_window(const int16_t *samples, float *out, float gain) {
+    spectrum_window(samples, active_window, gain, out, N);
+}
+
+static void restart_lateness() {
+    stream_samples = 0;
+    pending_late_us = 0;
+    pending_samples = 0;
+}
+
+static void update_lateness(int64_t captured_us, uint16_t samples) {
+    stream_samples += samples;
+    int64_t offset = captured_us - stream_samples * 1000000 / SAMPLE_RATE;
+    if (stream_samples == samples || offset < arrival_anchor_us) {
+        arrival_anchor_us = offset;
+    } else {
+        arrival_anchor_us += (offset - arrival_anchor_us) >> LATENESS_ANCHOR_SHIFT;
+    }
+    uint32_t late = (uint32_t)(offset - arrival_anchor_us);
+    if (late > pending_late_us) {
+        pending_late_us = late;
+    }
+    pending_samples += samples;
+}
 
-        int raw_adc = 0;
-        adc_oneshot_read(adc_handle, ADC_CHANNEL, &raw_adc);
+// Advance the sample history by one hop and record the capture and
+// preprocessing times in frame; returns the number of new samples (now at
+// the end of sample_history), or 0 if the read failed
+static uint16_t sample_audio(audio_frame_t *frame) {
+    // A cold history needs a full window before the first analysis frame
+    uint16_t needed = (history_fill < FFT_SIZE) ? (FFT_SIZE - history_fill) : hop_size;
 
-        complex_data[2 * i] = (float)raw_adc;
-        complex_data[2 * i + 1] = 0.0f;
+    // Allow two hop periods before counting the read as lost
+    const uint32_t timeout_ms = 2 * (1000 * needed / SAMPLE_RATE) + 10;
 
-        int64_t now = esp_timer_get_time();
-        int64_t delay_us = next_sample_time - now;
-        if (delay_us > 0) {
-            esp_rom_delay_us(delay_us);
+    // Slide the window: keep the newest FFT_SIZE - needed samples and append the new ones
+    memmove(sample_history, sample_history + needed, (FFT_SIZE - needed) * sizeof(sample_history[0]));
+    int16_t *fresh = sample_history + FFT_SIZE - needed;
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = source->read_frame(fresh, needed, timeout_ms);
+    frame->captured_us = esp_timer_get_time();
+    frame->capture_us = (uint32_t)(frame->captured_us - start);
+    if (ret != ESP_OK) {
+        if (ret != ESP_ERR_NOT_FOUND) {
+            printf("Audio capture failed with error: %d\n", ret);
         }
-        // int64_t elapsed = esp_timer_get_time() - start_time;
-        // printf("Sample time: %lld us\n", elapsed);
+        history_fill = 0;
+        agc_reset();
+        restart_lateness();
+        return 0;
+    }
+    update_lateness(frame->captured_us, needed);
+    // Each sample is DC-filtered exactly once, in place, as it enters the history
+    agc_process(fresh, needed);
+    frame->preprocess_us = (uint32_t)(esp_timer_get_time() - frame->captured_us);
+    history_fill = FFT_SIZE;
+    return needed;
+}
+
+static void update_frame_rate() {
+    int64_t now = esp_timer_get_time();
+    if (rate_window_start == 0) {
+        rate_window_start = now;
+    }
+    rate_window_frames++;
+
+    int64_t elapsed = now - rate_window_start;
+    if (elapsed >= FRAME_RATE_WINDOW_US) {
+        measured_frame_rate = (float)rate_window_frames * 1000000.0f / (float)elapsed;
+        rate_window_start = now;
+        rate_window_frames = 0;
+    }
+}
+
+bool fft_set_hop_size(uint16_t hop) {
+    if (hop == 0 || hop > FFT_SIZE) {
+        return false;
     }
+    hop_size = hop;
+    return true;
+}
+
+uint16_t fft_get_hop_size(void) {
+    return hop_size;
 }
 
-// Perform FFT and fill magnitude_bins array
-static void perform_fft() {
-    dsps_fft2r_fc32(complex_data, FFT_SIZE);
-    dsps_bit_rev_fc32(complex_data, FFT_SIZE);
+float fft_get_frame_rate(void) {
+    return measured_frame_rate;
+}
+
+void fft_reset_stream(void) {
+    // Drop whatever piled up in the capture buffer while nobody was reading
+    source->flush();
+    history_fill = 0;
+    agc_reset();
+    restart_lateness();
+    goertzel_bank_reset();
+    rate_window_start = 0;
+    rate_window_frames = 0;
+    measured_frame_rate = 0.0f;
+}
+
+bool fft_set_window(fft_window_t type) {
+    switch (type) {
+        case FFT_WINDOW_HANN:
+            active_window = Tables::hann.data();
+            break;
+        case FFT_WINDOW_BLACKMAN:
+            active_window = Tables::blackman.data();
+            break;
+        default:
+            return false;
+    }
+    fft_q15_set_window(type);
+    window_type = type;
+    return true;
+}
+
+fft_window_t fft_get_window(void) {
+    return window_type;
+}
+
+// Recover the N-point real spectrum from the N/2-point transform Z of the
+// packed input z[m] = x[2m] + j*x[2m+1], in place:
+//   X[k] = E[k] + W^k * O[k]
+//   E[k] = (Z[k] + conj(Z[N/2-k])) / 2,  O[k] = (Z[k] - conj(Z[N/2-k])) / 2j
+// X[k] and X[N/2-k] need the same two inputs, so they are produced as a
+// pair and written back over them. Bins 0..N/2-1 result; Nyquist is dropped.
+template <size_t N>
+static void real_fft_split(float *z) {
+    constexpr int half = N / 2;
+    const float *twiddle = fft_tables::Tables<N>::split_fc32.data();
+
+    // DC: imaginary parts of E and O vanish
+    z[0] = z[0] + z[1];
+    z[1] = 0.0f;
+
+    for (int k = 1; k <= half / 2; k++) {
+        const int j = half - k;
+        float zr = z[2 * k];
+        float zi = z[2 * k + 1];
+        float cr = z[2 * j];
+        float ci = -z[2 * j + 1];
+
+        // Bin k
+        float er = 0.5f * (zr + cr);
+        float ei = 0.5f * (zi + ci);
+        float or_ = 0.5f * (zi - ci);
+        float oi = -0.5f * (zr - cr);
+        float c = twiddle[2 * k];
+        float s = twiddle[2 * k + 1];
+        float xr = er + or_ * c + oi * s;
+        float xi = ei + oi * c - or_ * s;
+
+        // Bin j: the same terms with the roles of Z[k] and Z[j] swapped
+        float jer = er;
+        float jei = -ei;
+        float jor = or_;
+        float joi = -oi;
+        c = twiddle[2 * j];
+        s = twiddle[2 * j + 1];
+        z[2 * j] = jer + jor * c + joi * s;
+        z[2 * j + 1] = jei + joi * c - jor * s;
+
+        z[2 * k] = xr;
+        z[2 * k + 1] = xi;
+    }
+}
+
+// Run the radix-2 kernel in place; false (and logged) if esp-dsp rejected it
+static bool fft2r(float *data, int n) {
+    esp_err_t ret = fft2r_fc32(data, n, dsps_fft_w_table_fc32);
+    if (ret != ESP_OK) {
+        printf("FFT kernel failed with error: %d\n", ret);
+        return false;
+    }
+    return true;
+}
+
+// Perform FFT on a packed window and fill the power and magnitude arrays
+static bool perform_fft(float *data, float *power, float *mag) {
+    if (!fft2r(data, FFT_SIZE / 2)) {
+        return false;
+    }
+    fft_tables::bit_reverse(data, Tables::bit_reverse_packed);
+    real_fft_split<FFT_SIZE>(data);
+    spectrum_power(data, power, FFT_SIZE / 2);
+    spectrum_magnitude(power, mag, FFT_SIZE / 2);
+    return true;
+}
+
+bool fft_set_backend(fft_backend_t backend) {
+    if (backend != FFT_BACKEND_FLOAT && backend != FFT_BACKEND_Q15) {
+        return false;
+    }
+    active_backend = backend;
+    return true;
+}
+
+fft_backend_t fft_get_backend(void) {
+    return active_backend;
+}
+
+bool fft_set_analyzer(fft_analyzer_t analyzer) {
+    if (analyzer != FFT_ANALYZER_FFT && analyzer != FFT_ANALYZER_GOERTZEL) {
+        return false;
+    }
+    active_analyzer = analyzer;
+    return true;
+}
+
+fft_analyzer_t fft_get_analyzer(void) {
+    return active_analyzer;
+}
+
+bool fft_set_goertzel_freqs(const float *freqs_hz, uint8_t count) {
+    if (count == 0 || count > GOERTZEL_MAX_FILTERS) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        if (freqs_hz[i] <= 0.0f || freqs_hz[i] >= SAMPLE_RATE / 2.0f) {
+            return false;
+        }
+    }
+    taskENTER_CRITICAL(&goertzel_lock);
+    memcpy(pending_goertzel_freqs, freqs_hz, count * sizeof(freqs_hz[0]));
+    pending_goertzel_count = count;
+    taskEXIT_CRITICAL(&goertzel_lock);
+    return true;
+}
+
+float fft_get_analyzer_cost(fft_analyzer_t analyzer) {
+    if (analyzer != FFT_ANALYZER_FFT && analyzer != FFT_ANALYZER_GOERTZEL) {
+        return 0.0f;
+    }
+    return analyzer_cost[analyzer];
+}
+
+static void update_analyzer_cost(fft_analyzer_t analyzer, uint32_t cycles, uint16_t samples) {
+    cost_cycles[analyzer] += cycles;
+    cost_samples[analyzer] += samples;
+    if (cost_samples[analyzer] >= SAMPLE_RATE) {
+        analyzer_cost[analyzer] = (float)cost_cycles[analyzer] / cost_samples[analyzer];
+        cost_cycles[analyzer] = 0;
+        cost_samples[analyzer] = 0;
+    }
+}
+
+// Turn the current sample window into magnitude_bins (and power_bins for
+// the float backend) with the selected backend, stored in *backend;
+// returns false if the transform failed
+static bool analyze_window(fft_backend_t *backend) {
+    const float gain = normalization_gain();
+    *backend = active_backend;
+    if (*backend == FFT_BACKEND_Q15) {
+        return fft_q15_analyze(sample_history, complex_q15, magnitude_bins, gain);
+    }
+    load_window<FFT_SIZE>(sample_history, complex_data, gain);
+    return perform_fft(complex_data, power_bins, magnitude_bins);
+}
+
+// Original analysis path: full complex FFT over zero-imaginary input, no window.
+// Only kept as the baseline for fft_benchmark().
+static bool perform_fft_complex(const int16_t *samples, float *data, float *mag) {
+    for (int i = 0; i < FFT_SIZE; ++i) {
+        data[2 * i] = (float)samples[i];
+        data[2 * i + 1] = 0.0f;
+    }
+    if (!fft2r(data, FFT_SIZE)) {
+        return false;
+    }
+    fft_tables::bit_reverse(data, Tables::bit_reverse_full);
 
     for (int i = 0; i < FFT_SIZE / 2; i++) {
-        float real = complex_data[2 * i];
-        float imag = complex_data[2 * i + 1];
-        magnitude_bins[i] = sqrtf(real * real + imag * imag);
+        float real = data[2 * i];
+        float imag = data[2 * i + 1];
+        mag[i] = sqrtf(real * real + imag * imag);
     }
+    return true;
+}
+
+void fft_benchmark(int iterations) {
+    if (iterations <= 0) {
+        iterations = 100;
+    }
+
+    // Private buffers so the benchmark can run alongside the adaptive task
+    float *legacy_data = (float *)aligned_alloc(16, 2 * FFT_SIZE * sizeof(float));
+    float *bench_power = (float *)aligned_alloc(16, FFT_SIZE / 2 * sizeof(float));
+    float *bench_mag = (float *)aligned_alloc(16, FFT_SIZE / 2 * sizeof(float));
+    if (!legacy_data || !bench_power || !bench_mag) {
+        printf("FFT benchmark: out of memory\n");
+        free(legacy_data);
+        free(bench_power);
+        free(bench_mag);
+        return;
+    }
+
+    const float gain = normalization_gain();
+    bool ok = true;
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (int n = 0; n < iterations; n++) {
+        ok = perform_fft_complex(sample_history, legacy_data, bench_mag) && ok;
+    }
+    uint32_t complex_cycles = (esp_cpu_get_cycle_count() - start) / iterations;
+
+    start = esp_cpu_get_cycle_count();
+    for (int n = 0; n < iterations; n++) {
+        load_window<FFT_SIZE>(sample_history, legacy_data, gain);
+        ok = perform_fft(legacy_data, bench_power, bench_mag) && ok;
+    }
+    uint32_t real_cycles = (esp_cpu_get_cycle_count() - start) / iterations;
+
+    // legacy_data is large enough to double as the int16 scratch buffer
+    start = esp_cpu_get_cycle_count();
+    for (int n = 0; n < iterations; n++) {
+        ok = fft_q15_analyze(sample_history, (int16_t *)legacy_data, bench_mag, gain) && ok;
+    }
+    uint32_t q15_cycles = (esp_cpu_get_cycle_count() - start) / iterations;
+    free(legacy_data);
+    free(bench_power);
+    free(bench_mag);
+    if (!ok) {
+        printf("FFT benchmark: the FFT kernel failed, timings are meaningless\n");
+        return;
+    }
+
+    printf("FFT benchmark on %s (%d-point, %d runs, cycles per frame incl. conversion):\n",
+           CONFIG_IDF_TARGET, FFT_SIZE, iterations);
+    printf("  complex FFT, no window      : %lu\n", (unsigned long)complex_cycles);
+    printf("  float packed real + %-8s: %lu (%.0f%%)\n",
+           window_type == FFT_WINDOW_HANN ? "hann" : "blackman",
+           (unsigned long)real_cycles, 100.0f * real_cycles / complex_cycles);
+    printf("  q15 packed real + %-8s  : %lu (%.0f%%)\n",
+           window_type == FFT_WINDOW_HANN ? "hann" : "blackman",
+           (unsigned long)q15_cycles, 100.0f * q15_cycles / complex_cycles);
+    printf("  active backend: %s, faster on this chip: %s\n",
+           active_backend == FFT_BACKEND_Q15 ? "q15" : "float",
+           q15_cycles < real_cycles ? "q15" : "float");
+
+    // Live numbers include pitch and band extraction, so they cover the whole analyzer
+    printf("Analyzer cost while running (cycles per input sample, 0 = not run yet):\n");
+    printf("  fft (hop %u)            : %.1f\n", hop_size, fft_get_analyzer_cost(FFT_ANALYZER_FFT));
+    printf("  goertzel (%u filters/%u): %.1f\n", goertzel_bank_get_count(), goertzel_bank_get_block_size(),
+           fft_get_analyzer_cost(FFT_ANALYZER_GOERTZEL));
+    printf("  active analyzer: %s\n", active_analyzer == FFT_ANALYZER_GOERTZEL ? "goertzel" : "fft");
 }
 
 void get_dominant_frequency(float* out_freq, float* out_magnitude) {
-    int max_index = 1;
-    float max_value = magnitude_bins[1];
+    pitch_estimate_t est;
+    pitch_estimate(magnitude_bins, FFT_SIZE / 2, (float)SAMPLE_RATE / FFT_SIZE,
+                   FFT_PITCH_INTERP, FFT_PITCH_HPS, &est);
 
-    for (int i = 2; i < FFT_SIZE / 2; i++) {
-        if (magnitude_bins[i] > max_value) {
-            max_value = magnitude_bins[i];
-            max_index = i;
-        }
+    *out_freq = est.freq_hz;
+    *out_magnitude = est.magnitude;
+}
+
+bool fft_set_band_count(uint8_t count) {
+    if (count == 0 || count > FILTERBANK_MAX_BANDS) {
+        return false;
     }
+    // Rebuilt by the analysis task between frames so the table never changes under it
+    pending_band_count = count;
+    return true;
+}
+
+uint8_t fft_get_band_count(void) {
+    return filterbank_get_band_count();
+}
 
-    *out_freq = (float)max_index * SAMPLE_RATE / FFT_SIZE;
-    *out_magnitude = max_value;
+bool fft_get_latest_frame(audio_frame_t *out) {
+    taskENTER_CRITICAL(&frame_lock);
+    *out = latest_frame;
+    taskEXIT_CRITICAL(&frame_lock);
+    return out->seq != 0;
 }
 
-// void set_brightness(int brightness) {
-//     led_strip_set_brightness();
-// }
+// Number the frame and make it the one fft_get_latest_frame() returns
+static void publish_frame(audio_frame_t *frame) {
+    taskENTER_CRITICAL(&frame_lock);
+    frame->seq = latest_frame.seq + 1;
+    latest_frame = *frame;
+    taskEXIT_CRITICAL(&frame_lock);
+}
 
-// void set_color() {
-//     led_strip_set_pixel_color(0, 0, 0, 0); // Clear previous colors, index r g b
-// }
-void fft_control_lights() {
-    sample_audio();
-    perform_fft();
+static void apply_pending_band_count() {
+    uint8_t count = pending_band_count;
+    if (count == 0) {
+        return;
+    }
+    pending_band_count = 0;
+    if (count != filterbank_get_band_count()) {
+        filterbank_init(count, FILTERBANK_SCALE_LOG, FILTERBANK_MIN_FREQ,
+                        SAMPLE_RATE / 2.0f, FFT_SIZE / 2, (float)SAMPLE_RATE / FFT_SIZE);
+    }
+}
 
-    float freq, mag;
-    get_dominant_frequency(&freq, &mag);
-    // printf("Dominant Frequency: %.2f Hz, Magnitude: %.2f\n", freq, mag);
+static void apply_pending_goertzel_freqs() {
+    float freqs[GOERTZEL_MAX_FILTERS];
+    taskENTER_CRITICAL(&goertzel_lock);
+    uint8_t count = pending_goertzel_count;
+    memcpy(freqs, pending_goertzel_freqs, count * sizeof(freqs[0]));
+    pending_goertzel_count = 0;
+    taskEXIT_CRITICAL(&goertzel_lock);
+
+    if (count != 0) {
+        goertzel_bank_init(freqs, count, SAMPLE_RATE, GOERTZEL_DEFAULT_BLOCK);
+    }
+}
+
+// Full-spectrum frame: filterbank bands and interpolated pitch from the current window
+static bool analyze_fft(float *freq, float *mag) {
+    fft_backend_t backend;
+    if (!analyze_window(&backend)) {
+        return false;
+    }
+    apply_pending_band_count();
+    if (backend == FFT_BACKEND_Q15) {
+        filterbank_apply(magnitude_bins, band_levels);
+    } else {
+        filterbank_apply_power(power_bins, band_levels);
+    }
+    get_dominant_frequency(freq, mag);
+    return true;
+}
+
+// Feed the new samples to the Goertzel bank; returns true once a block has
+// completed, with one band per filter and the strongest filter as the pitch
+static bool analyze_goertzel(const int16_t *samples, uint16_t len, float *freq, float *mag) {
+    apply_pending_goertzel_freqs();
+    if (!goertzel_bank_push_block(samples, len)) {
+        return false;
+    }
+    goertzel_bank_get_magnitudes(band_levels);
+
+    // Same normalisation as the FFT path, for the bank's block length
+    const float scale = 2.0f / (goertzel_bank_get_block_size() * agc_get_level());
+    uint8_t count = goertzel_bank_get_count();
+    for (int i = 0; i < count; i++) {
+        band_levels[i] *= scale;
+    }
+    int strongest = spectrum_argmax(band_levels, count, mag);
+    *freq = goertzel_bank_get_frequency(strongest);
+    return true;
+}
 
-    int brightness = (int)(mag / 4095.0f * 255.0f);
-    if (brightness > 255) brightness = 255;
+bool fft_process_frame(audio_frame_t *frame) {
+    uint16_t new_samples = sample_audio(frame);
+    if (new_samples == 0) {
+        return false;
+    }
 
-    rgb_t color = map_frequency_to_color(freq, mag);
-    jetson_send_color(color); // Send color to Jetson
-    printf("Color: R:%d G:%d B:%d\n", color.r, color.g, color.b);
-    // printf("Brightness: %d\n", brightness);
+    float freq, mag;
+    uint8_t band_count;
+    uint16_t frame_samples;
+    const fft_analyzer_t analyzer = active_analyzer;
+    uint32_t start = esp_cpu_get_cycle_count();
+    if (analyzer != running_analyzer) {
+        // Don't mix audio from before the switch into the first Goertzel block
+        goertzel_bank_reset();
+        running_analyzer = analyzer;
+    }
+    if (analyzer == FFT_ANALYZER_GOERTZEL) {
+        bool ready = analyze_goertzel(sample_history + FFT_SIZE - new_samples, new_samples, &freq, &mag);
+        update_analyzer_cost(analyzer, esp_cpu_get_cycle_count() - start, new_samples);
+        if (!ready) {
+            return false;  // Block still filling
+        }
+        band_count = goertzel_bank_get_count();
+        frame_samples = goertzel_bank_get_block_size();
+    } else {
+        if (!analyze_fft(&freq, &mag)) {
+            return false;   // Kernel error, already logged
+        }
+        update_analyzer_cost(analyzer, esp_cpu_get_cycle_count() - start, new_samples);
+        band_count = filterbank_get_band_count();
+        frame_samples = hop_size;
+    }
+    int64_t analyzed = esp_timer_get_time();
+    frame->analysis_us = (uint32_t)(analyzed - frame->captured_us) - frame->preprocess_us;
+    update_frame_rate();
 
-    for (int i = 0; i < LED_COUNT; i++) {
-        led_strip_set_pixel_color(i, color.r, color.g, color.b);
+    // The tempo lags are in frames, so the detector follows hop and analyzer changes
+    if (beat_frame_samples != frame_samples) {
+        beat_detector_init((float)SAMPLE_RATE / frame_samples);
+        beat_frame_samples = frame_samples;
     }
-    
-    led_strip_set_brightness(brightness);
+    bool onset = beat_detector_process(band_levels, band_count, analyzed);
+
+    frame->timestamp_us = esp_timer_get_time();
+    frame->features_us = (uint32_t)(frame->timestamp_us - analyzed);
+    frame->dominant_freq = freq;
+    frame->dominant_magnitude = mag;
+    frame->onset = onset;
+    frame->bpm = beat_detector_get_bpm();
+    frame->band_count = band_count;
+    memcpy(frame->bands, band_levels, band_count * sizeof(band_levels[0]));
+    frame->late_us = pending_late_us;
+    frame->new_samples = (uint16_t)pending_samples;
+    pending_late_us = 0;
+    pending_samples = 0;
+    publish_frame(frame);
+    return true;
 }
\ No newline at end of file
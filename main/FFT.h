@@ -2,18 +2,134 @@
 #define FFT_H
 
 #include <stdbool.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "filterbank.h"
+#include "pitch_estimator.h"
+#include "audio_source.h"
 
-// Config
-#define SAMPLE_RATE 4000
-#define FFT_SIZE 256
-#define ADC_CHANNEL ADC_CHANNEL_3  // GPIO4
+// Config (menuconfig: "Audio analysis")
+#define SAMPLE_RATE CONFIG_AUDIO_SAMPLE_RATE
+#define FFT_SIZE CONFIG_AUDIO_FFT_SIZE
+#define ADC_CHANNEL ((adc_channel_t)CONFIG_AUDIO_ADC_CHANNEL)  // Channel 3 is GPIO4 on the ESP32-S3
+#define FFT_DEFAULT_HOP (FFT_SIZE / 4)  // New samples per analysis frame (62.5 fps at 256 points, 4 kHz)
+
+// Dominant pitch estimation: sub-bin peak interpolation plus a harmonic-product
+// check, accurate enough that FFT_SIZE 128 matches a 256-point argmax
+#define FFT_PITCH_INTERP PITCH_INTERP_GAUSSIAN
+#define FFT_PITCH_HPS true
+
+// Spectrum backend used at boot; can be changed at run time with fft_set_backend()
+#ifndef FFT_DEFAULT_BACKEND
+#define FFT_DEFAULT_BACKEND FFT_BACKEND_FLOAT
+#endif
+
+// Goertzel analyzer: kick, snare body, low/high vocal range, snare crack
+#define GOERTZEL_DEFAULT_FREQS {60.0f, 120.0f, 220.0f, 500.0f, 1000.0f, 1800.0f}
+#define GOERTZEL_DEFAULT_BLOCK (FFT_SIZE / 2)  // 31.25 fps at 256 points, 4 kHz
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-bool initialize_fft(void);
-void fft_control_lights(void);
+typedef enum {
+    FFT_WINDOW_HANN,
+    FFT_WINDOW_BLACKMAN
+} fft_window_t;
+
+typedef enum {
+    FFT_BACKEND_FLOAT,  // dsps_fft2r_fc32 on float buffers
+    FFT_BACKEND_Q15     // dsps_fft2r_sc16 on int16 buffers, integer magnitudes
+} fft_backend_t;
+
+typedef enum {
+    FFT_ANALYZER_FFT,       // Full spectrum: filterbank bands, interpolated pitch
+    FFT_ANALYZER_GOERTZEL   // Fixed frequencies only: one band per Goertzel filter
+} fft_analyzer_t;
+
+// One analysis frame, published after every STFT hop for renderers, the
+// web API and the UART link so none of them redo the spectrum work
+typedef struct {
+    uint32_t seq;                 // Increments with every frame, 0 = none yet
+    int64_t timestamp_us;         // esp_timer time the frame was published
+    float dominant_freq;          // Hz
+    float dominant_magnitude;     // Normalised by the AGC: ~1.0 at the current level
+    bool onset;                   // An onset was detected in this frame
+    float bpm;                    // Current tempo estimate, 0 if unknown
+    uint8_t band_count;
+    float bands[FILTERBANK_MAX_BANDS];  // Normalised RMS magnitude per band (or Goertzel magnitude), low to high
+
+    // Stage timing, for the pipeline's latency breakdown
+    int64_t captured_us;          // esp_timer time the newest sample was read
+    uint32_t capture_us;          // Blocked in the source read
+    uint32_t preprocess_us;       // DC removal and AGC
+    uint32_t analysis_us;         // Spectrum or Goertzel bank
+    uint32_t features_us;         // Beat detection and frame assembly
+
+    // Capture lateness: how long after its newest sample was due (by the
+    // stream's sample count) a read returned, relative to the earliest
+    // arrival seen recently so buffering delay and clock drift cancel out.
+    // Near zero while the analysis keeps up; large when the audio task was
+    // preempted or ran long and the source had to buffer.
+    uint32_t late_us;             // Worst lateness of the reads feeding this frame
+    uint16_t new_samples;         // Samples read since the previous frame
+} audio_frame_t;
+
+// Set up the analysis and open source, which feeds every frame from then on
+bool initialize_fft(const audio_source_t *source);
+
+// The source passed to initialize_fft()
+const audio_source_t *fft_get_source(void);
+
+// Capture one hop and analyse it. Returns true and fills frame (also
+// published to fft_get_latest_frame()) when a new analysis frame is ready;
+// false on a capture error or while a Goertzel block is still filling.
+bool fft_process_frame(audio_frame_t *frame);
+
+// Sliding-window STFT control. Each call to fft_process_frame() consumes
+// hop new samples and analyses the most recent FFT_SIZE of them.
+bool fft_set_hop_size(uint16_t hop);
+uint16_t fft_get_hop_size(void);
+
+// Analysis frames per second actually achieved, updated once per second
+float fft_get_frame_rate(void);
+
+// Analysis window applied before the FFT (tables are precomputed at init)
+bool fft_set_window(fft_window_t type);
+fft_window_t fft_get_window(void);
+
+// Spectrum backend; both produce the same magnitude scale
+bool fft_set_backend(fft_backend_t backend);
+fft_backend_t fft_get_backend(void);
+
+// Analysis engine used by fft_process_frame(). Switching takes effect from
+// the next call; the Goertzel bank publishes one frame per completed block.
+bool fft_set_analyzer(fft_analyzer_t analyzer);
+fft_analyzer_t fft_get_analyzer(void);
+
+// Replace the Goertzel filter frequencies (1 to GOERTZEL_MAX_FILTERS, in Hz,
+// below SAMPLE_RATE / 2). Applied by the analysis task between blocks.
+bool fft_set_goertzel_freqs(const float *freqs_hz, uint8_t count);
+
+// Measured analysis cost in CPU cycles per input sample, averaged over recent
+// frames of that analyzer; 0 if it has not run yet
+float fft_get_analyzer_cost(fft_analyzer_t analyzer);
+
+// Number of filterbank bands (1 to FILTERBANK_MAX_BANDS, e.g. 8/16/32).
+// The new table takes effect from the next analysis frame.
+bool fft_set_band_count(uint8_t count);
+uint8_t fft_get_band_count(void);
+
+// Copy the most recent analysis frame; returns false if none has been produced yet
+bool fft_get_latest_frame(audio_frame_t *out);
+
+// Compare the original complex FFT against the float and Q15 packed real
+// FFTs on the current sample window and print cycles per frame, next to
+// the live per-sample cost of the FFT and Goertzel analyzers
+void fft_benchmark(int iterations);
+
+// Discard buffered audio and refill the window, e.g. when adaptive mode resumes
+void fft_reset_stream(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,231 @@
+#include "adc_capture.h"
+#include "FFT.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "esp_adc/adc_continuous.h"
+#include "soc/soc_caps.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "adc_capture";
+
+// Output record layout differs between the original ESP32/S2 and newer chips
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+#define ADC_OUTPUT_TYPE         ADC_DIGI_OUTPUT_FORMAT_TYPE1
+#define ADC_GET_CHANNEL(p_data) ((p_data)->type1.channel)
+#define ADC_GET_DATA(p_data)    ((p_data)->type1.data)
+#else
+#define ADC_OUTPUT_TYPE         ADC_DIGI_OUTPUT_FORMAT_TYPE2
+#define ADC_GET_CHANNEL(p_data) ((p_data)->type2.channel)
+#define ADC_GET_DATA(p_data)    ((p_data)->type2.data)
+#endif
+
+// Converter samples per DMA conversion frame, and how many of those frames
+// the driver's ring buffer can hold before it starts dropping data
+#define ADC_CONV_SAMPLES   64
+#define ADC_POOL_FRAMES    8
+
+static adc_continuous_handle_t adc_handle = NULL;
+static int capture_channel = 0;
+static uint16_t decimation = 1;
+static uint32_t hw_rate_hz = 0;
+
+// Raw DMA records read back from the driver
+static uint8_t raw_buf[ADC_CONV_SAMPLES * SOC_ADC_DIGI_RESULT_BYTES];
+
+// Partial decimation state carried across reads
+static uint32_t acc_sum = 0;
+static uint16_t acc_count = 0;
+
+// Counters
+static uint32_t frame_count = 0;
+static volatile uint32_t overrun_count = 0;
+static uint32_t underrun_count = 0;
+
+// Called from ISR context when the driver pool is full and a conversion frame is lost
+static bool IRAM_ATTR on_pool_ovf(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user_data)
+{
+    overrun_count = overrun_count + 1;
+    return false;
+}
+
+esp_err_t adc_capture_init(int channel, uint32_t sample_rate_hz)
+{
+    if (adc_handle != NULL) {
+        ESP_LOGW(TAG, "ADC capture already running");
+        return ESP_OK;
+    }
+    if (sample_rate_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Run the converter at an integer multiple of the requested rate if the
+    // hardware cannot go that slow, and average the surplus samples away
+    decimation = 1;
+    while (sample_rate_hz * decimation < SOC_ADC_SAMPLE_FREQ_THRES_LOW) {
+        decimation++;
+    }
+    hw_rate_hz = sample_rate_hz * decimation;
+    if (hw_rate_hz > SOC_ADC_SAMPLE_FREQ_THRES_HIGH) {
+        ESP_LOGE(TAG, "Sample rate %lu Hz not supported", (unsigned long)sample_rate_hz);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    adc_continuous_handle_cfg_t handle_cfg = {
+        .max_store_buf_size = sizeof(raw_buf) * ADC_POOL_FRAMES,
+        .conv_frame_size = sizeof(raw_buf),
+    };
+    esp_err_t ret = adc_continuous_new_handle(&handle_cfg, &adc_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create ADC continuous handle: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    adc_digi_pattern_config_t pattern = {
+        .atten = ADC_ATTEN_DB_11,
+        .channel = (uint8_t)(channel & 0x7),
+        .unit = ADC_UNIT_1,
+        .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+    };
+    adc_continuous_config_t dig_cfg = {
+        .pattern_num = 1,
+        .adc_pattern = &pattern,
+        .sample_freq_hz = hw_rate_hz,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_OUTPUT_TYPE,
+    };
+    ret = adc_continuous_config(adc_handle, &dig_cfg);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure ADC: %s", esp_err_to_name(ret));
+        adc_continuous_deinit(adc_handle);
+        adc_handle = NULL;
+        return ret;
+    }
+
+    adc_continuous_evt_cbs_t cbs = {
+        .on_conv_done = NULL,
+        .on_pool_ovf = on_pool_ovf,
+    };
+    ESP_ERROR_CHECK(adc_continuous_register_event_callbacks(adc_handle, &cbs, NULL));
+
+    capture_channel = channel;
+    acc_sum = 0;
+    acc_count = 0;
+
+    ret = adc_continuous_start(adc_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start ADC: %s", esp_err_to_name(ret));
+        adc_continuous_deinit(adc_handle);
+        adc_handle = NULL;
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "ADC capture started: channel %d, %lu Hz (hw %lu Hz, decimation %u)",
+             channel, (unsigned long)sample_rate_hz, (unsigned long)hw_rate_hz, decimation);
+    return ESP_OK;
+}
+
+esp_err_t adc_capture_read_frame(int16_t *out, size_t len, uint32_t timeout_ms)
+{
+    if (adc_handle == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    size_t filled = 0;
+
+    while (filled < len) {
+        // Only ask for as many records as we still need, so unread samples
+        // stay in the driver's ring buffer for the next frame
+        size_t want = (len - filled) * decimation - acc_count;
+        size_t want_bytes = want * SOC_ADC_DIGI_RESULT_BYTES;
+        if (want_bytes > sizeof(raw_buf)) {
+            want_bytes = sizeof(raw_buf);
+        }
+
+        int64_t remaining_us = deadline - esp_timer_get_time();
+        if (remaining_us < 0) {
+            remaining_us = 0;
+        }
+
+        uint32_t got_bytes = 0;
+        esp_err_t ret = adc_continuous_read(adc_handle, raw_buf, want_bytes, &got_bytes,
+                                            (uint32_t)(remaining_us / 1000));
+        if (ret == ESP_ERR_TIMEOUT || (ret == ESP_OK && got_bytes == 0 && remaining_us == 0)) {
+            underrun_count++;
+            return ESP_ERR_TIMEOUT;
+        }
+        if (ret != ESP_OK) {
+            return ret;
+        }
+
+        for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= got_bytes && filled < len; i += SOC_ADC_DIGI_RESULT_BYTES) {
+            adc_digi_output_data_t *p = (adc_digi_output_data_t *)&raw_buf[i];
+            if (ADC_GET_CHANNEL(p) != (uint32_t)capture_channel) {
+                continue;
+            }
+            acc_sum += ADC_GET_DATA(p);
+            if (++acc_count == decimation) {
+                out[filled++] = (int16_t)(acc_sum / decimation);
+                acc_sum = 0;
+                acc_count = 0;
+            }
+        }
+    }
+
+    frame_count++;
+    return ESP_OK;
+}
+
+esp_err_t adc_capture_flush(void)
+{
+    if (adc_handle == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    acc_sum = 0;
+    acc_count = 0;
+    return adc_continuous_flush_pool(adc_handle);
+}
+
+void adc_capture_get_stats(adc_capture_stats_t *out)
+{
+    out->frames = frame_count;
+    out->overruns = overrun_count;
+    out->underruns = underrun_count;
+    out->hw_rate_hz = hw_rate_hz;
+    out->decimation = decimation;
+}
+
+esp_err_t adc_capture_deinit(void)
+{
+    if (adc_handle == NULL) {
+        return ESP_OK;
+    }
+    adc_continuous_stop(adc_handle);
+    esp_err_t ret = adc_continuous_deinit(adc_handle);
+    adc_handle = NULL;
+    return ret;
+}
+
+static esp_err_t adc_source_open(uint32_t sample_rate_hz)
+{
+    return adc_capture_init(ADC_CHANNEL, sample_rate_hz);
+}
+
+static void adc_source_get_stats(audio_source_stats_t *out)
+{
+    out->frames = frame_count;
+    out->overruns = overrun_count;
+    out->underruns = underrun_count;
+    out->lost = 0;
+    out->hw_rate_hz = hw_rate_hz;
+}
+
+const audio_source_t adc_audio_source = {
+    .name = "adc",
+    .open = adc_source_open,
+    .read_frame = adc_capture_read_frame,
+    .flush = adc_capture_flush,
+    .close = adc_capture_deinit,
+    .get_stats = adc_source_get_stats,
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <esp_err.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "audio_source.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Counters describing the health of the background ADC capture
+ */
+typedef struct {
+    uint32_t frames;     // Frames handed out by adc_capture_read_frame()
+    uint32_t overruns;   // DMA conversion frames dropped because nobody was reading
+    uint32_t underruns;  // Reads that timed out before a full frame was available
+    uint32_t hw_rate_hz; // Actual converter rate (SAMPLE_RATE * decimation)
+    uint16_t decimation; // Converter samples averaged into one output sample
+} adc_capture_stats_t;
+
+/**
+ * @brief Start continuous (DMA) sampling of one ADC1 channel
+ *
+ * Samples are collected by the ADC DMA engine into the driver's ring buffer
+ * in the background, so the CPU is free while a frame is being captured and
+ * the sample clock is driven by hardware instead of busy-wait loops.
+ *
+ * If the requested rate is below what the converter supports on this chip,
+ * the converter runs at an integer multiple of it and the extra samples are
+ * averaged down.
+ *
+ * @param channel ADC1 channel to sample (e.g. ADC_CHANNEL_3)
+ * @param sample_rate_hz Output sample rate in Hz
+ * @return esp_err_t ESP_OK on success, otherwise error
+ */
+esp_err_t adc_capture_init(int channel, uint32_t sample_rate_hz);
+
+/**
+ * @brief Block until the next len samples are available and copy them out
+ *
+ * Samples are raw 12-bit ADC codes (0-4095). The calling task sleeps while
+ * waiting for the DMA engine, it does not spin.
+ *
+ * @param out Destination buffer for len samples
+ * @param len Number of samples to read
+ * @param timeout_ms Maximum time to wait for the whole frame
+ * @return esp_err_t ESP_OK on success, ESP_ERR_TIMEOUT on underrun
+ */
+esp_err_t adc_capture_read_frame(int16_t *out, size_t len, uint32_t timeout_ms);
+
+/**
+ * @brief Discard all samples currently buffered by the driver
+ *
+ * Used when the consumer has been idle so the next frame is fresh audio.
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t adc_capture_flush(void);
+
+/**
+ * @brief Get a snapshot of the capture counters
+ *
+ * @param out Filled with the current counters
+ */
+void adc_capture_get_stats(adc_capture_stats_t *out);
+
+/**
+ * @brief Stop sampling and release the ADC
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t adc_capture_deinit(void);
+
+// The ADC capture as an analysis audio source, on the configured ADC_CHANNEL
+extern const audio_source_t adc_audio_source;
+
+#ifdef __cplusplus
+}
+#endif
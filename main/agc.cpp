@@ -0,0 +1,116 @@
+#include "agc.h"
+#include <math.h>
+
+// DC blocker corner; low enough to leave a 40 Hz kick untouched
+#define DC_BLOCK_CUTOFF_HZ 10.0f
+// Noise floor rises this slowly and falls at the attack rate; a sound that
+// never changes level is eventually treated as background
+#define FLOOR_RISE_MS 20000.0f
+// Sounds need to be this far above the floor to reach full scale
+#define FLOOR_MARGIN 3.0f
+// Never normalise to less than this many counts (disconnected mic)
+#define MIN_LEVEL 8.0f
+// Reference used when the AGC is disabled: half the 12-bit ADC range
+#define FIXED_LEVEL 2048.0f
+
+static float sample_rate = 0.0f;
+static float dc_pole = 0.0f;
+
+// DC blocker state: y[n] = x[n] - x[n-1] + pole * y[n-1]
+static float prev_input = 0.0f;
+static float prev_output = 0.0f;
+static bool seeded = false;
+
+static uint32_t attack_ms = AGC_DEFAULT_ATTACK_MS;
+static uint32_t release_ms = AGC_DEFAULT_RELEASE_MS;
+static bool enabled = true;
+
+// Written by the analysis task, read by the web/console handlers
+static volatile float envelope = 0.0f;
+static volatile float noise_floor = 0.0f;
+
+void agc_init(float sample_rate_hz) {
+    sample_rate = sample_rate_hz;
+    dc_pole = 1.0f - 2.0f * (float)M_PI * DC_BLOCK_CUTOFF_HZ / sample_rate_hz;
+    agc_reset();
+}
+
+void agc_reset(void) {
+    seeded = false;
+    prev_output = 0.0f;
+    envelope = 0.0f;
+    noise_floor = 0.0f;
+}
+
+// Smoothing factor of a one-pole follower with time constant tau_ms over len samples
+static float block_coeff(float tau_ms, size_t len) {
+    return 1.0f - expf(-(float)len * 1000.0f / (tau_ms * sample_rate));
+}
+
+void agc_process(int16_t *samples, size_t len) {
+    if (len == 0 || sample_rate <= 0.0f) {
+        return;
+    }
+    if (!seeded) {
+        prev_input = samples[0];
+        seeded = true;
+    }
+
+    float x1 = prev_input;
+    float y1 = prev_output;
+    float peak = 0.0f;
+    for (size_t i = 0; i < len; i++) {
+        float x = samples[i];
+        float y = x - x1 + dc_pole * y1;
+        x1 = x;
+        y1 = y;
+        samples[i] = (int16_t)lrintf(y);
+        float a = fabsf(y);
+        if (a > peak) peak = a;
+    }
+    prev_input = x1;
+    prev_output = y1;
+
+    float attack = block_coeff((float)attack_ms, len);
+    float env = envelope;
+    float floor = noise_floor;
+    if (env == 0.0f) {
+        // First block after a reset: take it as full scale, floor just below
+        env = peak;
+        floor = peak / FLOOR_MARGIN;
+    }
+    env += (peak > env ? attack : block_coeff((float)release_ms, len)) * (peak - env);
+    floor += (peak < floor ? attack : block_coeff(FLOOR_RISE_MS, len)) * (peak - floor);
+    envelope = env;
+    noise_floor = floor;
+}
+
+float agc_get_level(void) {
+    if (!enabled) {
+        return FIXED_LEVEL;
+    }
+    float level = fmaxf(envelope, FLOOR_MARGIN * noise_floor);
+    return fmaxf(level, MIN_LEVEL);
+}
+
+bool agc_set_times(uint32_t attack, uint32_t release) {
+    if (attack == 0 || release == 0 || attack > release) {
+        return false;
+    }
+    attack_ms = attack;
+    release_ms = release;
+    return true;
+}
+
+void agc_get_times(uint32_t *attack, uint32_t *release) {
+    *attack = attack_ms;
+    *release = release_ms;
+}
+
+void agc_set_enabled(bool enable) {
+    enabled = enable;
+}
+
+bool agc_is_enabled(void) {
+    return enabled;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define AGC_DEFAULT_ATTACK_MS 10
+#define AGC_DEFAULT_RELEASE_MS 2000
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Streaming DC removal and automatic gain control
+ *
+ * Runs once over every new block of samples as it arrives from the ADC, in
+ * place: a one-pole DC-blocking IIR removes the mid-rail offset, and the
+ * same pass measures the block peak. The peak feeds an envelope follower
+ * (fast attack, slow release) and a noise-floor tracker (fast fall, slow
+ * rise). agc_get_level() is the amplitude that should read as full scale;
+ * the analysis folds 1/level into its windowing pass, so normalisation
+ * costs no extra pass or copy.
+ */
+
+/**
+ * @brief Set up the filters for a sample rate and reset all state
+ */
+void agc_init(float sample_rate_hz);
+
+/**
+ * @brief Forget the filter history and level, e.g. after a capture gap
+ *
+ * The next block seeds the DC filter from its first sample so the
+ * mid-rail offset does not ring through the output.
+ */
+void agc_reset(void);
+
+/**
+ * @brief Remove DC in place and update the level trackers
+ *
+ * @param samples Raw ADC samples, replaced by the offset-free signal
+ * @param len Number of samples
+ */
+void agc_process(int16_t *samples, size_t len);
+
+/**
+ * @brief Signal amplitude (ADC counts) that currently maps to 1.0
+ *
+ * The larger of the peak envelope and a margin above the noise floor, so
+ * a quiet room is not amplified up to full brightness.
+ */
+float agc_get_level(void);
+
+// Envelope time constants; take effect from the next block
+bool agc_set_times(uint32_t attack_ms, uint32_t release_ms);
+void agc_get_times(uint32_t *attack_ms, uint32_t *release_ms);
+
+// Disabled: fixed full-scale reference of half the ADC range
+void agc_set_enabled(bool enabled);
+bool agc_is_enabled(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -217,6 +217,9 @@ esp_err_t app_driver_light_set_defaults(uint16_t endpoint_id)
     void *priv_data = endpoint::get_priv_data(endpoint_id);
     esp_matter_attr_val_t val = esp_matter_invalid(NULL);
 
+    /* Apply all defaults as one change, so the strip renders once */
+    led_strip_begin();
+
     /* Setting brightness */
     attribute_t *attribute = attribute::get(endpoint_id, LevelControl::Id, LevelControl::Attributes::CurrentLevel::Id);
     attribute::get_val(attribute, &val);
@@ -250,13 +253,14 @@ esp_err_t app_driver_light_set_defaults(uint16_t endpoint_id)
     attribute::get_val(attribute, &val);
     err |= app_driver_light_set_power(priv_data, &val);
 
+    err |= led_strip_commit();
     return err;
 }
 
 app_driver_handle_t app_driver_light_init()
 {
-    // Initialize LED strip with GPIO and LED count
-    esp_err_t err = led_strip_init(2, LED_COUNT);
+    // Initialize the LED outputs from menuconfig (GPIO, LED count, color order)
+    esp_err_t err = led_strip_init_configured();
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize LED strip: %s", esp_err_to_name(err));
     }
@@ -264,7 +268,7 @@ app_driver_handle_t app_driver_light_init()
     // Retry once more after a short delay if failed
     if (err != ESP_OK) {
         vTaskDelay(pdMS_TO_TICKS(500));
-        err = led_strip_init(2, LED_COUNT);
+        err = led_strip_init_configured();
         if (err != ESP_OK) {
             ESP_LOGE(TAG, "Second attempt to initialize LED strip failed: %s", esp_err_to_name(err));
         }
@@ -31,8 +31,14 @@ using namespace chip::DeviceLayer;
 #endif
 
 #include "led_strip_control.h"
+#include "led_effects.h"
 #include "web_server.h"
 #include "FFT.h"
+#include "adc_capture.h"
+#include "i2s_capture.h"
+#include "udp_pcm_source.h"
+#include "audio_console.h"
+#include "audio_pipeline.h"
 #include "jetson_uart.h"
 #include "weather.h"
 
@@ -181,31 +187,6 @@ static void print_wifi_mac(void)
     }
 }
 
-// Task to periodically run FFT processing when adaptive mode is active
-static void adaptive_mode_task(void *pvParameters)
-{
-    TickType_t last_wake_time = xTaskGetTickCount();
-    const TickType_t frequency = pdMS_TO_TICKS(500); // Adaptive mode sample frequency
-
-    while (1) {
-        // If in adaptive mode and powered on, run the FFT control
-        if (led_strip_get_mode() == MODE_ADAPTIVE && led_strip_get_power_state()) {
-            // This function should set individual pixel colors via led_strip_set_pixel_color()
-            fft_control_lights();
-
-            // Explicitly call led_strip_update() AFTER fft_control_lights() sets the pixels.
-            // led_strip_update() will check the mode/power again and call led_strip_refresh().
-            esp_err_t update_err = led_strip_update();
-            if (update_err != ESP_OK) {
-                ESP_LOGE(TAG, "Adaptive task: Failed to update LED strip: %s", esp_err_to_name(update_err));
-            }
-        }
-
-        // Delay until next cycle
-        vTaskDelayUntil(&last_wake_time, frequency);
-    }
-}
-
 // Task to periodically update lighting based on environmental conditions
 static void environmental_mode_task(void *pvParameters)
 {
@@ -235,18 +216,7 @@ static void environmental_mode_task(void *pvParameters)
              ESP_LOGE(TAG, "Failed to update target environmental state: %s", esp_err_to_name(update_target_err));
              // Log error, but continue the loop
         }
-
-        // If the strip is currently in environmental mode, apply the updated target color
-        if (led_strip_get_mode() == MODE_ENVIRONMENTAL) {
-            ESP_LOGI(TAG, "Environmental task: Mode is ENV, triggering strip update.");
-            // Call the main update function which will use the new environmental_r/g/b values
-            esp_err_t apply_err = update_led_strip();
-            if (apply_err != ESP_OK) {
-                ESP_LOGE(TAG, "Environmental task: Failed to apply updated state to strip: %s", esp_err_to_name(apply_err));
-            }
-        } else {
-            ESP_LOGD(TAG, "Environmental task: Mode is not ENV, skipping strip update.");
-        }
+        // In environmental mode the render task picks the new colour up on its next frame
 
         // Wait until the next 15-minute interval
         vTaskDelayUntil(&last_wake_time, frequency);
@@ -262,6 +232,9 @@ extern "C" void app_main()
 
     /* Initialize driver */
     app_driver_handle_t light_handle = app_driver_light_init();
+    if (led_effects_init() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to install the effect engine");
+    }
     app_driver_handle_t button_handle = app_driver_button_init();
     app_reset_button_register(button_handle);
 
@@ -359,6 +332,7 @@ extern "C" void app_main()
     esp_matter::console::diagnostics_register_commands();
     esp_matter::console::wifi_register_commands();
     esp_matter::console::factoryreset_register_commands();
+    audio_console_register_commands();
 #if CONFIG_OPENTHREAD_CLI
     esp_matter::console::otcli_register_commands();
 #endif
@@ -401,13 +375,22 @@ extern "C" void app_main()
     }
     // --- End Initial Weather Fetch ---
 
-    if (!initialize_fft()) {
+#if CONFIG_AUDIO_SOURCE_I2S
+    const audio_source_t *audio_source = &i2s_audio_source;
+#elif CONFIG_AUDIO_SOURCE_UDP
+    const audio_source_t *audio_source = &udp_audio_source;
+#else
+    const audio_source_t *audio_source = &adc_audio_source;
+#endif
+    if (!initialize_fft(audio_source)) {
         ESP_LOGE(TAG, "FFT initialization failed");
         return;
     } else {
-        // Init UART and create task for adaptive mode FFT processing
+        // Init UART and start the audio capture/render tasks for adaptive mode
         uart_init();
-        xTaskCreate(adaptive_mode_task, "adaptive_mode_task", 4096, NULL, 5, NULL);
+        if (audio_pipeline_start() != ESP_OK) {
+            ESP_LOGE(TAG, "Audio pipeline failed to start");
+        }
 
     }
 
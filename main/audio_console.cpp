@@ -0,0 +1,186 @@
+#include "audio_console.h"
+#include "FFT.h"
+#include "agc.h"
+#include "audio_pipeline.h"
+#include "spectrum_kernels.h"
+#include <esp_matter_console.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static esp_err_t audio_bench_handler(int argc, char **argv)
+{
+    int iterations = (argc > 0) ? atoi(argv[0]) : 100;
+    fft_benchmark(iterations);
+    return ESP_OK;
+}
+
+static esp_err_t audio_kernels_handler(int argc, char **argv)
+{
+    int len = (argc > 0) ? atoi(argv[0]) : FFT_SIZE;
+    int iterations = (argc > 1) ? atoi(argv[1]) : 100;
+    spectrum_kernels_benchmark(len, iterations);
+    return ESP_OK;
+}
+
+static esp_err_t audio_backend_handler(int argc, char **argv)
+{
+    if (argc > 0) {
+        if (strcmp(argv[0], "float") == 0) {
+            fft_set_backend(FFT_BACKEND_FLOAT);
+        } else if (strcmp(argv[0], "q15") == 0) {
+            fft_set_backend(FFT_BACKEND_Q15);
+        } else {
+            printf("Unknown backend: %s (use float or q15)\n", argv[0]);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    printf("FFT backend: %s\n", fft_get_backend() == FFT_BACKEND_Q15 ? "q15" : "float");
+    return ESP_OK;
+}
+
+static esp_err_t audio_analyzer_handler(int argc, char **argv)
+{
+    if (argc > 0) {
+        if (strcmp(argv[0], "fft") == 0) {
+            fft_set_analyzer(FFT_ANALYZER_FFT);
+        } else if (strcmp(argv[0], "goertzel") == 0) {
+            fft_set_analyzer(FFT_ANALYZER_GOERTZEL);
+        } else {
+            printf("Unknown analyzer: %s (use fft or goertzel)\n", argv[0]);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    printf("Analyzer: %s\n", fft_get_analyzer() == FFT_ANALYZER_GOERTZEL ? "goertzel" : "fft");
+    return ESP_OK;
+}
+
+static esp_err_t audio_agc_handler(int argc, char **argv)
+{
+    if (argc == 1 && (strcmp(argv[0], "on") == 0 || strcmp(argv[0], "off") == 0)) {
+        agc_set_enabled(strcmp(argv[0], "on") == 0);
+    } else if (argc == 2) {
+        if (!agc_set_times((uint32_t)atoi(argv[0]), (uint32_t)atoi(argv[1]))) {
+            printf("Attack and release must be > 0 ms, attack <= release\n");
+            return ESP_ERR_INVALID_ARG;
+        }
+    } else if (argc != 0) {
+        printf("Usage: audio agc [on|off|<attack_ms> <release_ms>]\n");
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t attack, release;
+    agc_get_times(&attack, &release);
+    printf("AGC %s, attack %lu ms, release %lu ms, level %.1f\n", agc_is_enabled() ? "on" : "off",
+           (unsigned long)attack, (unsigned long)release, agc_get_level());
+    return ESP_OK;
+}
+
+static void print_stats(const char *name, const audio_stage_stats_t *s)
+{
+    printf("  %-10s %8lu %8lu %8lu %8lu %8lu\n", name, (unsigned long)s->last_us, (unsigned long)s->min_us,
+           (unsigned long)s->avg_us, (unsigned long)s->p99_us, (unsigned long)s->max_us);
+}
+
+static esp_err_t audio_latency_handler(int argc, char **argv)
+{
+    if (argc == 1 && strcmp(argv[0], "reset") == 0) {
+        audio_pipeline_reset_latency();
+        return ESP_OK;
+    }
+    if (argc == 2 && strcmp(argv[0], "trace") == 0) {
+        audio_pipeline_set_trace(strcmp(argv[1], "on") == 0);
+        return ESP_OK;
+    }
+
+    audio_latency_t stats;
+    audio_pipeline_get_latency(&stats);
+    printf("Frames rendered %lu, dropped %lu, skipped %lu\n", (unsigned long)stats.rendered,
+           (unsigned long)stats.dropped, (unsigned long)stats.skipped);
+    printf("  %-10s %8s %8s %8s %8s %8s (us, last %d frames)\n", "stage", "last", "min", "avg", "p99", "max",
+           AUDIO_STATS_WINDOW);
+    for (int i = 0; i < AUDIO_STAGE_COUNT; i++) {
+        print_stats(audio_pipeline_stage_name((audio_stage_t)i), &stats.stage[i]);
+    }
+
+    audio_jitter_t jitter;
+    audio_pipeline_get_jitter(&jitter);
+    print_stats("lateness", &jitter.late);
+    printf("Frames analysed %lu, late by over half a hop %lu\n", (unsigned long)jitter.frames,
+           (unsigned long)jitter.late_frames);
+    printf("  samples by lateness:");
+    for (int i = 0; i < AUDIO_LATENESS_BUCKETS; i++) {
+        uint32_t bound = audio_pipeline_lateness_bucket_us(i);
+        if (bound) {
+            printf(" <%lu:%lu", (unsigned long)bound, (unsigned long)jitter.samples[i]);
+        } else {
+            printf(" more:%lu", (unsigned long)jitter.samples[i]);
+        }
+    }
+    printf("\n");
+    return ESP_OK;
+}
+
+static esp_err_t audio_source_handler(int argc, char **argv)
+{
+    const audio_source_t *source = fft_get_source();
+    if (source == NULL) {
+        printf("No audio source open\n");
+        return ESP_ERR_INVALID_STATE;
+    }
+    printf("Source %s at %d Hz\n", source->name, SAMPLE_RATE);
+    if (source->get_stats) {
+        audio_source_stats_t stats;
+        source->get_stats(&stats);
+        printf("  frames %lu, overruns %lu, underruns %lu, lost %lu, hw rate %lu Hz\n",
+               (unsigned long)stats.frames, (unsigned long)stats.overruns, (unsigned long)stats.underruns,
+               (unsigned long)stats.lost, (unsigned long)stats.hw_rate_hz);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t audio_dispatch(int argc, char **argv)
+{
+    if (argc < 1 || strcmp(argv[0], "help") == 0) {
+        printf("audio bench [iterations]  - compare FFT analysis paths\n");
+        printf("audio kernels [len] [iterations] - spectrum kernels vs scalar loops\n");
+        printf("audio backend [float|q15] - show or select the spectrum backend\n");
+        printf("audio analyzer [fft|goertzel] - show or select the adaptive-mode analyzer\n");
+        printf("audio agc [on|off|<attack_ms> <release_ms>] - show or tune the gain control\n");
+        printf("audio latency [reset|trace on|off] - per-stage latency and capture jitter\n");
+        printf("audio source              - capture source and its counters\n");
+        return ESP_OK;
+    }
+    if (strcmp(argv[0], "bench") == 0) {
+        return audio_bench_handler(argc - 1, &argv[1]);
+    }
+    if (strcmp(argv[0], "kernels") == 0) {
+        return audio_kernels_handler(argc - 1, &argv[1]);
+    }
+    if (strcmp(argv[0], "backend") == 0) {
+        return audio_backend_handler(argc - 1, &argv[1]);
+    }
+    if (strcmp(argv[0], "analyzer") == 0) {
+        return audio_analyzer_handler(argc - 1, &argv[1]);
+    }
+    if (strcmp(argv[0], "agc") == 0) {
+        return audio_agc_handler(argc - 1, &argv[1]);
+    }
+    if (strcmp(argv[0], "latency") == 0) {
+        return audio_latency_handler(argc - 1, &argv[1]);
+    }
+    if (strcmp(argv[0], "source") == 0) {
+        return audio_source_handler(argc - 1, &argv[1]);
+    }
+    printf("Unknown audio command: %s\n", argv[0]);
+    return ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t audio_console_register_commands(void)
+{
+    static const esp_matter::console::command_t command = {
+        .name = "audio",
+        .description = "Audio analysis diagnostics. Usage: matter esp audio <bench|kernels|backend|analyzer|agc|latency|source|help>",
+        .handler = audio_dispatch,
+    };
+    return esp_matter::console::add_commands(&command, 1);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Register the "audio" diagnostics command with the Matter console
+ *
+ * Available as "matter esp audio <subcommand>" once esp_matter::console::init()
+ * has been called.
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t audio_console_register_commands(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,278 @@
+#include "audio_pipeline.h"
+#include "FFT.h"
+#include "spsc_ring.h"
+#include "led_strip_control.h"
+#include "freq_color_mapper.h"
+#include "jetson_uart.h"
+#include "rolling_stats.h"
+#include <esp_log.h>
+#include <esp_timer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <atomic>
+#include <string.h>
+
+static const char *TAG = "audio_pipeline";
+
+// Wi-Fi and the Matter stack live on core 0; keep sampling off it when we can
+#if CONFIG_FREERTOS_UNICORE || portNUM_PROCESSORS == 1
+#define AUDIO_TASK_CORE 0
+#else
+#define AUDIO_TASK_CORE 1
+#endif
+#define AUDIO_TASK_PRIORITY 6
+#define AUDIO_TASK_STACK 4096
+
+// A few frames of slack so a slow LED frame doesn't stall the capture
+#define FRAME_RING_SIZE 8
+// Band vectors go out over UART at a lower rate than the analysis
+#define JETSON_BANDS_INTERVAL_US 50000
+
+typedef RollingStats<AUDIO_STATS_WINDOW> FrameStats;
+
+static SpscRing<audio_frame_t, FRAME_RING_SIZE> frame_ring;
+
+// Capture through features are written by the audio task, the rest by the
+// LED render task (through adaptive_generator). reset() may race a record() and keep one stale value.
+static FrameStats stage_stats[AUDIO_STAGE_COUNT];
+static FrameStats lateness_stats;                                   // Audio task
+static std::atomic<uint32_t> lateness_hist[AUDIO_LATENESS_BUCKETS]; // Audio task
+static std::atomic<uint32_t> analysed_frames{0};                    // Audio task
+static std::atomic<uint32_t> late_frames{0};                        // Audio task
+static std::atomic<uint32_t> dropped_frames{0};                     // Audio task
+static std::atomic<uint32_t> rendered_frames{0};                    // Render task
+static std::atomic<uint32_t> skipped_frames{0};                     // Render task
+static volatile bool trace_enabled = false;
+
+static int64_t last_bands_sent = 0;   // Audio task
+
+static bool adaptive_active()
+{
+    return led_strip_get_mode() == MODE_ADAPTIVE && led_strip_get_power_state();
+}
+
+// Single-writer increment; no read-modify-write needed
+static void bump(std::atomic<uint32_t> *counter, uint32_t n = 1)
+{
+    counter->store(counter->load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+static int lateness_bucket(uint32_t late_us)
+{
+    uint32_t scaled = late_us / AUDIO_LATENESS_BUCKET0_US;
+    int bucket = (scaled == 0) ? 0 : 32 - __builtin_clz(scaled);
+    return (bucket < AUDIO_LATENESS_BUCKETS) ? bucket : AUDIO_LATENESS_BUCKETS - 1;
+}
+
+// Audio task side of the statistics, for every analysed frame whether or
+// not it is rendered
+static void record_analysis(const audio_frame_t *frame)
+{
+    stage_stats[AUDIO_STAGE_CAPTURE].record(frame->capture_us);
+    stage_stats[AUDIO_STAGE_PREPROCESS].record(frame->preprocess_us);
+    stage_stats[AUDIO_STAGE_ANALYSIS].record(frame->analysis_us);
+    stage_stats[AUDIO_STAGE_FEATURES].record(frame->features_us);
+
+    // Every sample of the frame is counted at the frame's worst lateness
+    lateness_stats.record(frame->late_us);
+    bump(&lateness_hist[lateness_bucket(frame->late_us)], frame->new_samples);
+    bump(&analysed_frames);
+    uint32_t half_hop_us = (uint32_t)(500000ull * fft_get_hop_size() / SAMPLE_RATE);
+    if (frame->late_us > half_hop_us) {
+        bump(&late_frames);
+    }
+}
+
+// Colour and band levels for the Jetson. Sent from the audio task, not the
+// render task, so UART writes never hold up the strip or its state lock.
+static void send_to_jetson(const audio_frame_t *frame)
+{
+    jetson_send_color(map_frequency_to_color(frame->dominant_freq, frame->dominant_magnitude));
+    if (frame->timestamp_us - last_bands_sent >= JETSON_BANDS_INTERVAL_US) {
+        jetson_send_bands(frame->bands, frame->band_count);
+        last_bands_sent = frame->timestamp_us;
+    }
+}
+
+// Capture and analysis. Each iteration blocks on the ADC for one STFT hop,
+// so the loop is paced by the sample clock.
+static void audio_task(void *pvParameters)
+{
+    const TickType_t idle_delay = pdMS_TO_TICKS(100); // Mode poll interval while inactive
+    const int64_t rate_log_interval_us = 10 * 1000 * 1000;
+    bool was_active = false;
+    int64_t last_rate_log = 0;
+    audio_frame_t frame;
+
+    while (1) {
+        if (!adaptive_active()) {
+            was_active = false;
+            vTaskDelay(idle_delay);
+            continue;
+        }
+        if (!was_active) {
+            // Audio buffered while idle is stale, start from a fresh window
+            fft_reset_stream();
+            was_active = true;
+        }
+
+        if (fft_process_frame(&frame)) {
+            if (frame_ring.push(frame)) {
+                led_strip_request_frame();
+            } else {
+                bump(&dropped_frames);
+            }
+            record_analysis(&frame);
+            send_to_jetson(&frame);
+        }
+
+        int64_t now = esp_timer_get_time();
+        if (now - last_rate_log >= rate_log_interval_us) {
+            ESP_LOGI(TAG, "%.1f analysis frames/s (hop %u) on core %d",
+                     fft_get_frame_rate(), fft_get_hop_size(), xPortGetCoreID());
+            last_rate_log = now;
+        }
+    }
+}
+
+// LED render task side of the statistics
+static void record_latency(const audio_frame_t *frame, int64_t render_start, int64_t mapped, int64_t render_end,
+                           uint32_t skipped)
+{
+    uint32_t queue_us = (uint32_t)(render_start - frame->timestamp_us);
+    uint32_t map_us = (uint32_t)(mapped - render_start);
+    uint32_t render_us = (uint32_t)(render_end - mapped);
+    uint32_t total_us = (uint32_t)(render_end - frame->captured_us);
+
+    stage_stats[AUDIO_STAGE_QUEUE].record(queue_us);
+    stage_stats[AUDIO_STAGE_MAP].record(map_us);
+    stage_stats[AUDIO_STAGE_RENDER].record(render_us);
+    stage_stats[AUDIO_STAGE_TOTAL].record(total_us);
+    bump(&rendered_frames);
+    bump(&skipped_frames, skipped);
+
+    if (trace_enabled) {
+        ESP_LOGI(TAG, "frame %lu: late %lu capture %lu pre %lu analysis %lu features %lu queue %lu map %lu "
+                 "render %lu total %lu us",
+                 (unsigned long)frame->seq, (unsigned long)frame->late_us, (unsigned long)frame->capture_us,
+                 (unsigned long)frame->preprocess_us, (unsigned long)frame->analysis_us,
+                 (unsigned long)frame->features_us, (unsigned long)queue_us, (unsigned long)map_us,
+                 (unsigned long)render_us, (unsigned long)total_us);
+    }
+}
+
+// Frame generator for adaptive mode, run by the LED render task on the
+// frame tick after new analysis arrives. Renders the newest queued frame;
+// older ones are skipped, but their onsets are kept.
+static bool adaptive_generator(int64_t now_us, rgb_t *pixels, uint16_t count, void *ctx)
+{
+    audio_frame_t frame;
+    audio_frame_t next;
+    if (!frame_ring.pop(&frame)) {
+        return false;
+    }
+    uint32_t skipped = 0;
+    while (frame_ring.pop(&next)) {
+        next.onset = next.onset || frame.onset;
+        frame = next;
+        skipped++;
+    }
+
+    int64_t render_start = esp_timer_get_time();
+    rgb_t color = map_frequency_to_color(frame.dominant_freq, frame.dominant_magnitude);
+    int64_t mapped = esp_timer_get_time();
+
+    // The magnitude is already in the colour; the strip's own brightness applies on output
+    bool changed = false;
+    for (int i = 0; i < count; i++) {
+        changed = changed || pixels[i].r != color.r || pixels[i].g != color.g || pixels[i].b != color.b;
+        pixels[i] = color;
+    }
+    record_latency(&frame, render_start, mapped, esp_timer_get_time(), skipped);
+    return changed;
+}
+
+esp_err_t audio_pipeline_start(void)
+{
+    esp_err_t err = led_strip_set_generator(MODE_ADAPTIVE, adaptive_generator, NULL, false);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (xTaskCreatePinnedToCore(audio_task, "audio_capture", AUDIO_TASK_STACK, NULL, AUDIO_TASK_PRIORITY,
+                                NULL, AUDIO_TASK_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create audio task");
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Audio task pinned to core %d", AUDIO_TASK_CORE);
+    return ESP_OK;
+}
+
+static void summarize(const FrameStats &stats, audio_stage_stats_t *out, uint32_t *scratch)
+{
+    FrameStats::Summary sum;
+    stats.summarize(&sum, scratch);
+    out->last_us = sum.last;
+    out->min_us = sum.min;
+    out->avg_us = sum.avg;
+    out->p99_us = sum.p99;
+    out->max_us = sum.max;
+}
+
+void audio_pipeline_get_latency(audio_latency_t *out)
+{
+    uint32_t scratch[AUDIO_STATS_WINDOW];
+    for (int i = 0; i < AUDIO_STAGE_COUNT; i++) {
+        summarize(stage_stats[i], &out->stage[i], scratch);
+    }
+    out->rendered = rendered_frames.load(std::memory_order_relaxed);
+    out->dropped = dropped_frames.load(std::memory_order_relaxed);
+    out->skipped = skipped_frames.load(std::memory_order_relaxed);
+}
+
+void audio_pipeline_get_jitter(audio_jitter_t *out)
+{
+    uint32_t scratch[AUDIO_STATS_WINDOW];
+    summarize(lateness_stats, &out->late, scratch);
+    for (int i = 0; i < AUDIO_LATENESS_BUCKETS; i++) {
+        out->samples[i] = lateness_hist[i].load(std::memory_order_relaxed);
+    }
+    out->frames = analysed_frames.load(std::memory_order_relaxed);
+    out->late_frames = late_frames.load(std::memory_order_relaxed);
+}
+
+void audio_pipeline_reset_latency(void)
+{
+    for (int i = 0; i < AUDIO_STAGE_COUNT; i++) {
+        stage_stats[i].reset();
+    }
+    lateness_stats.reset();
+    for (int i = 0; i < AUDIO_LATENESS_BUCKETS; i++) {
+        lateness_hist[i].store(0, std::memory_order_relaxed);
+    }
+    analysed_frames.store(0, std::memory_order_relaxed);
+    late_frames.store(0, std::memory_order_relaxed);
+    dropped_frames.store(0, std::memory_order_relaxed);
+    rendered_frames.store(0, std::memory_order_relaxed);
+    skipped_frames.store(0, std::memory_order_relaxed);
+}
+
+uint32_t audio_pipeline_lateness_bucket_us(int bucket)
+{
+    if (bucket < 0 || bucket >= AUDIO_LATENESS_BUCKETS - 1) {
+        return 0;
+    }
+    return (uint32_t)AUDIO_LATENESS_BUCKET0_US << bucket;
+}
+
+void audio_pipeline_set_trace(bool enabled)
+{
+    trace_enabled = enabled;
+}
+
+const char *audio_pipeline_stage_name(audio_stage_t stage)
+{
+    static const char *names[AUDIO_STAGE_COUNT] = {
+        "capture", "preprocess", "analysis", "features", "queue", "map", "render", "total",
+    };
+    return (stage < AUDIO_STAGE_COUNT) ? names[stage] : "unknown";
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Stages of one frame's trip from the ADC to the LEDs
+ */
+typedef enum {
+    AUDIO_STAGE_CAPTURE,     // Blocked in the source read (mostly waiting for the hop)
+    AUDIO_STAGE_PREPROCESS,  // DC removal and AGC
+    AUDIO_STAGE_ANALYSIS,    // Spectrum or Goertzel bank
+    AUDIO_STAGE_FEATURES,    // Beat detection and frame assembly
+    AUDIO_STAGE_QUEUE,       // Waiting in the ring for the LED render task's next frame tick
+    AUDIO_STAGE_MAP,         // Frequency to colour mapping
+    AUDIO_STAGE_RENDER,      // UART and framebuffer fill (the output stage is in led_output_stats_t)
+    AUDIO_STAGE_TOTAL,       // Newest sample read to frame rendered
+    AUDIO_STAGE_COUNT
+} audio_stage_t;
+
+// Over the last AUDIO_STATS_WINDOW frames, except max
+#define AUDIO_STATS_WINDOW 256
+
+typedef struct {
+    uint32_t last_us;
+    uint32_t min_us;
+    uint32_t avg_us;
+    uint32_t p99_us;
+    uint32_t max_us;   // Since start or the last reset
+} audio_stage_stats_t;
+
+typedef struct {
+    audio_stage_stats_t stage[AUDIO_STAGE_COUNT];
+    uint32_t rendered;   // Frames that reached the LEDs
+    uint32_t dropped;    // Frames lost because the ring was full
+    uint32_t skipped;    // Frames superseded by a newer one before rendering
+} audio_latency_t;
+
+// Lateness histogram buckets: bucket 0 is under 16 us and each one after
+// doubles the bound, so the last holds everything from 16 ms up
+#define AUDIO_LATENESS_BUCKETS 12
+#define AUDIO_LATENESS_BUCKET0_US 16
+
+typedef struct {
+    audio_stage_stats_t late;   // Per-frame capture lateness (audio_frame_t::late_us)
+    uint32_t samples[AUDIO_LATENESS_BUCKETS];  // Samples by the lateness of the read that delivered them
+    uint32_t frames;            // Frames analysed
+    uint32_t late_frames;       // Frames whose reads ran later than half a hop
+} audio_jitter_t;
+
+/**
+ * @brief Start the audio task and install the adaptive frame generator
+ *
+ * The audio task is pinned to the app core, away from Wi-Fi and Matter,
+ * and runs capture and analysis whenever adaptive mode is active. Frames go
+ * to the LED render task through a lock-free single-producer/single-consumer
+ * ring, so the next hop is captured while the previous one is rendered; the
+ * adaptive generator takes the newest on the next frame tick.
+ * Call after initialize_fft(), uart_init() and led_strip_init().
+ */
+esp_err_t audio_pipeline_start(void);
+
+/**
+ * @brief Per-stage latency of recent frames
+ *
+ * The counters are always on and lock-free: each series has one writer
+ * (the audio task for the analysis stages, the LED render task for the rest)
+ * and the min/avg/p99 are worked out here, on the caller's time.
+ */
+void audio_pipeline_get_latency(audio_latency_t *out);
+
+// Capture lateness of recent frames
+void audio_pipeline_get_jitter(audio_jitter_t *out);
+
+// Clears both the latency and the jitter statistics
+void audio_pipeline_reset_latency(void);
+
+// Upper bound of a lateness bucket in microseconds, 0 for the open-ended last one
+uint32_t audio_pipeline_lateness_bucket_us(int bucket);
+
+// Log the stage breakdown of every rendered frame
+void audio_pipeline_set_trace(bool enabled);
+
+const char *audio_pipeline_stage_name(audio_stage_t stage);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <esp_err.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Where the analysis gets its samples from
+ *
+ * The analysis only ever sees blocks of int16 samples at SAMPLE_RATE; a
+ * source hides how they are produced (ADC or I2S DMA, a UDP stream, a WAV file
+ * on the host replay tool). Samples may carry a DC offset, which the
+ * preprocessing removes, but should stay within a 12-bit swing so both
+ * FFT backends keep their headroom. Sources with wider samples (digital
+ * mics, network PCM) scale them down to that range.
+ */
+
+/**
+ * @brief Health counters common to every source
+ */
+typedef struct {
+    uint32_t frames;     // Frames handed out by read_frame()
+    uint32_t overruns;   // Input dropped because the buffer was full (nobody reading)
+    uint32_t underruns;  // Reads that timed out before a full frame was available
+    uint32_t lost;       // Input lost upstream (network packets), 0 for local sources
+    uint32_t hw_rate_hz; // Rate the hardware or sender actually runs at
+} audio_source_stats_t;
+
+typedef struct {
+    const char *name;
+
+    // Start producing samples at sample_rate_hz
+    esp_err_t (*open)(uint32_t sample_rate_hz);
+
+    // Block until len samples are available. ESP_ERR_TIMEOUT on underrun,
+    // ESP_ERR_NOT_FOUND once a finite source (file) is exhausted.
+    esp_err_t (*read_frame)(int16_t *out, size_t len, uint32_t timeout_ms);
+
+    // Drop buffered samples so the next read is fresh audio
+    esp_err_t (*flush)(void);
+
+    esp_err_t (*close)(void);
+
+    // Optional, may be NULL
+    void (*get_stats)(audio_source_stats_t *out);
+} audio_source_t;
+
+#ifdef __cplusplus
+}
+#endif
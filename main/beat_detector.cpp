@@ -0,0 +1,284 @@
+#include "beat_detector.h"
+#include "filterbank.h"
+#include "spectrum_kernels.h"
+#include "freertos/FreeRTOS.h"
+#include <math.h>
+#include <string.h>
+
+// Log compression applied to band levels before differencing
+#define FLUX_LOG_GAIN 100.0f
+// Onset when flux exceeds mean + THRESHOLD_K * stddev of the recent window
+#define THRESHOLD_K 1.5f
+// Minimum flux, so silence with tiny fluctuations never triggers
+#define THRESHOLD_FLOOR 0.05f
+// Minimum spacing between onsets (limits to 1.5x BEAT_MAX_BPM). Counted in
+// frames rather than timestamps, so replay faster than real time sees the
+// same onsets as the device.
+#define REFRACTORY_S 0.2f
+// Autocorrelation memory, per frame (~4 s at 62.5 fps)
+#define ACF_DECAY 0.996f
+// Tempo prior: log-Gaussian around 120 BPM, one octave wide
+#define PRIOR_CENTER_BPM 120.0f
+#define PRIOR_OCTAVES 1.0f
+// A tempo is only published with enough recent onsets (decayed like the
+// autocorrelation, so about the last 4 s) and an autocorrelation peak that
+// clearly stands out from the lag average. A steady tone has neither.
+#define TEMPO_MIN_ONSETS 2.0f
+#define TEMPO_MIN_PEAK_RATIO 1.5f
+
+// Rate of the onset-strength series the tempo tracker sees. Above what the
+// lag buffers cover (high sample rates, small hops) frames are pooled in
+// groups of tempo_decimation, keeping the strongest.
+static float tempo_rate = 0.0f;
+static uint16_t tempo_decimation = 1;
+static uint16_t tempo_pooled = 0;
+static float tempo_peak = 0.0f;
+static bool tempo_onset = false;     // An onset in the group being pooled
+
+// Spectral flux state
+static float prev_log_bands[FILTERBANK_MAX_BANDS];
+static uint8_t prev_count = 0;
+
+// Adaptive threshold: ring of recent flux values with running sums
+static float flux_ring[BEAT_FLUX_WINDOW];
+static uint16_t flux_pos = 0;
+static uint16_t flux_fill = 0;
+static float flux_sum = 0.0f;
+static float flux_sq_sum = 0.0f;
+static float prev_flux = 0.0f;
+
+// Tempo: onset strength history and decaying autocorrelation per lag
+static float onset_ring[BEAT_ONSET_HISTORY];
+static uint16_t onset_pos = 0;
+static uint32_t onset_frames = 0;
+static float acf[BEAT_MAX_LAGS];
+static float acf_zero = 0.0f;
+static float lag_prior[BEAT_MAX_LAGS];
+static uint16_t lag_min = 0;
+static uint16_t lag_count = 0;
+static float onset_density = 0.0f;   // Decaying count of recent onsets
+
+// Published results
+static beat_onset_t latest_onset;
+static uint32_t refractory_frames = 1;
+static uint32_t frames_since_onset = UINT32_MAX;
+static float bpm = 0.0f;
+static float confidence = 0.0f;
+static portMUX_TYPE beat_lock = portMUX_INITIALIZER_UNLOCKED;
+
+bool beat_detector_init(float frame_rate_hz) {
+    uint16_t decimation = 1;
+    while (frame_rate_hz > 0.0f && ceilf(frame_rate_hz / decimation * 60.0f / BEAT_MIN_BPM) >= BEAT_ONSET_HISTORY) {
+        decimation++;
+    }
+    float rate = frame_rate_hz / decimation;
+
+    uint16_t min_lag = (uint16_t)floorf(rate * 60.0f / BEAT_MAX_BPM);
+    uint16_t max_lag = (uint16_t)ceilf(rate * 60.0f / BEAT_MIN_BPM);
+    if (min_lag < 2 || max_lag >= BEAT_ONSET_HISTORY || max_lag - min_lag + 1 > BEAT_MAX_LAGS) {
+        tempo_rate = 0.0f;  // Disables processing until a usable rate is set
+        return false;
+    }
+
+    tempo_rate = rate;
+    tempo_decimation = decimation;
+    tempo_pooled = 0;
+    tempo_peak = 0.0f;
+    tempo_onset = false;
+    refractory_frames = (uint32_t)ceilf(frame_rate_hz * REFRACTORY_S);
+    frames_since_onset = UINT32_MAX;
+    lag_min = min_lag;
+    lag_count = max_lag - min_lag + 1;
+
+    for (int i = 0; i < lag_count; i++) {
+        float lag_bpm = tempo_rate * 60.0f / (lag_min + i);
+        float octaves = log2f(lag_bpm / PRIOR_CENTER_BPM) / PRIOR_OCTAVES;
+        lag_prior[i] = expf(-0.5f * octaves * octaves);
+    }
+
+    memset(prev_log_bands, 0, sizeof(prev_log_bands));
+    prev_count = 0;
+    memset(flux_ring, 0, sizeof(flux_ring));
+    flux_pos = flux_fill = 0;
+    flux_sum = flux_sq_sum = prev_flux = 0.0f;
+    memset(onset_ring, 0, sizeof(onset_ring));
+    onset_pos = 0;
+    onset_frames = 0;
+    memset(acf, 0, sizeof(acf));
+    acf_zero = 0.0f;
+    onset_density = 0.0f;
+
+    taskENTER_CRITICAL(&beat_lock);
+    bpm = 0.0f;
+    confidence = 0.0f;
+    taskEXIT_CRITICAL(&beat_lock);
+    return true;
+}
+
+static float spectral_flux(const float *bands, uint8_t count) {
+    if (count != prev_count) {
+        // Band layout changed: restart the difference from this frame
+        spectrum_log1p(bands, FLUX_LOG_GAIN, prev_log_bands, count);
+        prev_count = count;
+        return 0.0f;
+    }
+
+    float log_bands[FILTERBANK_MAX_BANDS];
+    spectrum_log1p(bands, FLUX_LOG_GAIN, log_bands, count);
+
+    float flux = 0.0f;
+    for (int b = 0; b < count; b++) {
+        float d = log_bands[b] - prev_log_bands[b];
+        if (d > 0.0f) {
+            flux += d;
+        }
+        prev_log_bands[b] = log_bands[b];
+    }
+    return flux / count;
+}
+
+static void update_tempo(float strength, bool onset) {
+    onset_ring[onset_pos] = strength;
+    onset_density = ACF_DECAY * onset_density + (onset ? 1.0f : 0.0f);
+
+    // Decaying autocorrelation, one multiply-add per tracked lag
+    acf_zero = ACF_DECAY * acf_zero + strength * strength;
+    for (int i = 0; i < lag_count; i++) {
+        uint16_t idx = (onset_pos + BEAT_ONSET_HISTORY - (lag_min + i)) % BEAT_ONSET_HISTORY;
+        acf[i] = ACF_DECAY * acf[i] + strength * onset_ring[idx];
+    }
+    onset_pos = (onset_pos + 1) % BEAT_ONSET_HISTORY;
+    if (onset_frames < UINT32_MAX) {
+        onset_frames++;
+    }
+
+    // Wait until the longest lag has real history behind it
+    if (onset_frames < (uint32_t)(lag_min + lag_count) || acf_zero <= 0.0f) {
+        return;
+    }
+
+    int best = 0;
+    float best_score = acf[0] * lag_prior[0];
+    float acf_sum = acf[0];
+    for (int i = 1; i < lag_count; i++) {
+        float score = acf[i] * lag_prior[i];
+        if (score > best_score) {
+            best_score = score;
+            best = i;
+        }
+        acf_sum += acf[i];
+    }
+
+    // No periodic onsets: report no tempo rather than the strongest noise lag
+    float acf_mean = acf_sum / lag_count;
+    if (onset_density < TEMPO_MIN_ONSETS || acf_mean <= 0.0f || acf[best] < TEMPO_MIN_PEAK_RATIO * acf_mean) {
+        taskENTER_CRITICAL(&beat_lock);
+        bpm = 0.0f;
+        confidence = 0.0f;
+        taskEXIT_CRITICAL(&beat_lock);
+        return;
+    }
+
+    // Parabolic refinement of the peak lag
+    float lag = (float)(lag_min + best);
+    if (best > 0 && best < lag_count - 1) {
+        float a = acf[best - 1];
+        float b = acf[best];
+        float c = acf[best + 1];
+        float denom = a - 2.0f * b + c;
+        if (denom < 0.0f) {
+            lag += 0.5f * (a - c) / denom;
+        }
+    }
+
+    taskENTER_CRITICAL(&beat_lock);
+    bpm = tempo_rate * 60.0f / lag;
+    confidence = fminf(1.0f, acf[best] / acf_zero);
+    taskEXIT_CRITICAL(&beat_lock);
+}
+
+bool beat_detector_process(const float *bands, uint8_t count, int64_t timestamp_us) {
+    if (tempo_rate <= 0.0f || count == 0) {
+        return false;
+    }
+
+    float flux = spectral_flux(bands, count);
+
+    float threshold = THRESHOLD_FLOOR;
+    if (flux_fill > 0) {
+        float mean = flux_sum / flux_fill;
+        float var = flux_sq_sum / flux_fill - mean * mean;
+        float candidate = mean + THRESHOLD_K * sqrtf(var > 0.0f ? var : 0.0f);
+        if (candidate > threshold) {
+            threshold = candidate;
+        }
+    }
+
+    // Onset on a rising flux that clears the threshold, outside the refractory period
+    if (frames_since_onset < UINT32_MAX) {
+        frames_since_onset++;
+    }
+    bool onset = flux > threshold && flux > prev_flux && frames_since_onset >= refractory_frames;
+    if (onset) {
+        frames_since_onset = 0;
+        taskENTER_CRITICAL(&beat_lock);
+        latest_onset.seq++;
+        latest_onset.timestamp_us = timestamp_us;
+        latest_onset.strength = flux / threshold;
+        taskEXIT_CRITICAL(&beat_lock);
+    }
+    prev_flux = flux;
+
+    // Slide the threshold window
+    if (flux_fill == BEAT_FLUX_WINDOW) {
+        float old = flux_ring[flux_pos];
+        flux_sum -= old;
+        flux_sq_sum -= old * old;
+    } else {
+        flux_fill++;
+    }
+    flux_ring[flux_pos] = flux;
+    flux_sum += flux;
+    flux_sq_sum += flux * flux;
+    flux_pos = (flux_pos + 1) % BEAT_FLUX_WINDOW;
+
+    // Tempo works on the flux above the local mean
+    float strength = flux - flux_sum / flux_fill;
+    tempo_peak = fmaxf(tempo_peak, strength);
+    tempo_onset = tempo_onset || onset;
+    if (++tempo_pooled == tempo_decimation) {
+        update_tempo(tempo_peak, tempo_onset);
+        tempo_pooled = 0;
+        tempo_peak = 0.0f;
+        tempo_onset = false;
+    }
+
+    return onset;
+}
+
+bool beat_detector_poll_onset(uint32_t *last_seq, beat_onset_t *out) {
+    taskENTER_CRITICAL(&beat_lock);
+    beat_onset_t onset = latest_onset;
+    taskEXIT_CRITICAL(&beat_lock);
+
+    if (onset.seq == 0 || onset.seq == *last_seq) {
+        return false;
+    }
+    *last_seq = onset.seq;
+    *out = onset;
+    return true;
+}
+
+float beat_detector_get_bpm(void) {
+    taskENTER_CRITICAL(&beat_lock);
+    float value = bpm;
+    taskEXIT_CRITICAL(&beat_lock);
+    return value;
+}
+
+float beat_detector_get_confidence(void) {
+    taskENTER_CRITICAL(&beat_lock);
+    float value = confidence;
+    taskEXIT_CRITICAL(&beat_lock);
+    return value;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BEAT_MIN_BPM 60.0f
+#define BEAT_MAX_BPM 200.0f
+#define BEAT_FLUX_WINDOW 48          // Frames in the adaptive threshold window
+#define BEAT_ONSET_HISTORY 128       // Frames of onset strength kept for tempo (>= longest lag)
+#define BEAT_MAX_LAGS 112            // Autocorrelation lags tracked between MAX_BPM and MIN_BPM
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief A detected onset
+ */
+typedef struct {
+    uint32_t seq;           // Increments with every onset, 0 = none yet
+    int64_t timestamp_us;   // Timestamp of the analysis frame it was found in
+    float strength;         // Flux above the adaptive threshold, in threshold units
+} beat_onset_t;
+
+/**
+ * @brief Reset the detector for a given analysis frame rate
+ *
+ * All state lives in fixed static buffers; nothing is allocated and the
+ * per-frame work is O(bands + lags) with a small constant stack footprint.
+ * Onsets are detected at the full frame rate; if that is too fast for the
+ * tempo history (high sample rates), tempo runs on pooled groups of frames.
+ *
+ * @param frame_rate_hz Nominal analysis frames per second (SAMPLE_RATE / hop)
+ * @return true on success, false if the rate cannot cover the BPM range
+ */
+bool beat_detector_init(float frame_rate_hz);
+
+/**
+ * @brief Feed one frame of band levels
+ *
+ * Computes half-wave rectified spectral flux of the log-compressed bands,
+ * compares it against a running mean + k * stddev threshold and updates a
+ * decaying autocorrelation of the onset strength for tempo estimation.
+ *
+ * @param bands Band levels from the filterbank
+ * @param count Number of bands
+ * @param timestamp_us Frame timestamp
+ * @return true if this frame is an onset
+ */
+bool beat_detector_process(const float *bands, uint8_t count, int64_t timestamp_us);
+
+/**
+ * @brief Check for an onset newer than the caller's last seen one
+ *
+ * Each consumer keeps its own last_seq, so several renderers can poll
+ * independently without consuming each other's events.
+ *
+ * @param last_seq In: last onset seen by the caller. Out: updated when a new onset is returned.
+ * @param out Filled with the latest onset if there is a new one
+ * @return true if a new onset was returned
+ */
+bool beat_detector_poll_onset(uint32_t *last_seq, beat_onset_t *out);
+
+/**
+ * @brief Current tempo estimate in beats per minute
+ *
+ * 0 until there is enough history, and whenever the recent audio has too
+ * few onsets or no clear periodicity (a sustained tone, silence).
+ */
+float beat_detector_get_bpm(void);
+
+/**
+ * @brief Confidence of the tempo estimate (0-1, autocorrelation peak vs. lag-0 energy)
+ */
+float beat_detector_get_confidence(void);
+
+#ifdef __cplusplus
+}
+#endif
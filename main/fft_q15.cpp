@@ -0,0 +1,97 @@
+#include "fft_q15.h"
+#include "fft_tables.h"
+#include "esp_dsp.h"
+#include <stdio.h>
+
+// esp-dsp's sc16 kernel for this chip, on the table dsps_fft2r_init_sc16()
+// built (without it the kernel returns ESP_ERR_DSP_UNINITIALIZED)
+#if dsps_fft2r_sc16_aes3_enabled
+#define fft2r_sc16(data, n, w) dsps_fft2r_sc16_aes3_(data, n, w)
+#elif dsps_fft2r_sc16_ae32_enabled
+#define fft2r_sc16(data, n, w) dsps_fft2r_sc16_ae32_(data, n, w)
+#else
+#define fft2r_sc16(data, n, w) dsps_fft2r_sc16_ansi_(data, n, w)
+#endif
+
+using Tables = fft_tables::Tables<FFT_SIZE>;
+
+// Samples are offset-free 12-bit values; they are shifted up into the Q15
+// range, leaving one bit of headroom for a rail-to-rail signal
+#define Q15_INPUT_SHIFT 3
+
+// The raw (peak <= 1) window in use, from rodata
+static const int16_t *window_q15 = Tables::hann_q15.data();
+
+// sc16 halves every butterfly stage, so its output is the transform divided
+// by the FFT length (FFT_SIZE/2 for the packed input). The window's
+// coherent gain is folded in here too.
+static constexpr float base_scale = (float)(FFT_SIZE / 2) / (float)(1 << Q15_INPUT_SHIFT);
+
+// Converts the integer magnitude estimate back to the float path's scale
+static float magnitude_scale = base_scale * Tables::hann_gain;
+
+void fft_q15_set_window(fft_window_t type) {
+    if (type == FFT_WINDOW_BLACKMAN) {
+        window_q15 = Tables::blackman_q15.data();
+        magnitude_scale = base_scale * Tables::blackman_gain;
+    } else {
+        window_q15 = Tables::hann_q15.data();
+        magnitude_scale = base_scale * Tables::hann_gain;
+    }
+}
+
+// Alpha-max-plus-beta-min with two coefficient sets, within about 1.2%
+// of the true magnitude and free of multiplies wider than 32 bits
+static inline int32_t magnitude_estimate(int32_t re, int32_t im) {
+    uint32_t a = (uint32_t)(re < 0 ? -re : re);
+    uint32_t b = (uint32_t)(im < 0 ? -im : im);
+    uint32_t hi = a > b ? a : b;
+    uint32_t lo = a > b ? b : a;
+    uint32_t est0 = hi + ((5 * lo) >> 5);
+    uint32_t est1 = ((27 * hi) >> 5) + ((71 * lo) >> 7);
+    return (int32_t)(est0 > est1 ? est0 : est1);
+}
+
+bool fft_q15_analyze(const int16_t *samples, int16_t *work, float *mag, float gain) {
+    // The gain rides on the final int-to-float conversion, which happens anyway
+    const float scale = magnitude_scale * gain;
+
+    for (int i = 0; i < FFT_SIZE; i++) {
+        int32_t x = (int32_t)samples[i] << Q15_INPUT_SHIFT;
+        work[i] = (int16_t)((x * window_q15[i]) >> 15);
+    }
+
+    esp_err_t ret = fft2r_sc16(work, FFT_SIZE / 2, dsps_fft_w_table_sc16);
+    if (ret != ESP_OK) {
+        printf("Q15 FFT kernel failed with error: %d\n", ret);
+        return false;
+    }
+    fft_tables::bit_reverse(work, Tables::bit_reverse_packed);
+
+    // Same split as the float path, carried at 2x scale to keep the halving exact
+    const int16_t *z = work;
+    constexpr int half = FFT_SIZE / 2;
+    const int16_t *split_twiddle_q15 = Tables::split_q15.data();
+    int32_t dc = z[0] + z[1];
+    mag[0] = (float)(dc < 0 ? -dc : dc) * scale;
+
+    for (int k = 1; k < half; k++) {
+        int32_t zr = z[2 * k];
+        int32_t zi = z[2 * k + 1];
+        int32_t cr = z[2 * (half - k)];
+        int32_t ci = -z[2 * (half - k) + 1];
+
+        int32_t er2 = zr + cr;
+        int32_t ei2 = zi + ci;
+        int32_t or2 = zi - ci;
+        int32_t oi2 = cr - zr;
+
+        int32_t c = split_twiddle_q15[2 * k];
+        int32_t s = split_twiddle_q15[2 * k + 1];
+        int32_t xr2 = er2 + ((or2 * c) >> 15) + ((oi2 * s) >> 15);
+        int32_t xi2 = ei2 + ((oi2 * c) >> 15) - ((or2 * s) >> 15);
+
+        mag[k] = (float)magnitude_estimate(xr2, xi2) * (0.5f * scale);
+    }
+    return true;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "FFT.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Fixed-point (Q15) spectrum backend
+ *
+ * Runs the same packed real FFT as the float path on esp-dsp's
+ * dsps_fft2r_sc16, using int16 buffers throughout and an integer
+ * magnitude estimate. Only the final per-bin magnitude is converted to
+ * float so both backends fill the same magnitude_bins array. Windows are
+ * compile-time tables; the twiddles are esp-dsp's, so initialize_fft()
+ * must have run dsps_fft2r_init_sc16().
+ */
+
+/**
+ * @brief Select the analysis window used by fft_q15_analyze()
+ */
+void fft_q15_set_window(fft_window_t type);
+
+/**
+ * @brief Window, transform and estimate magnitudes for one frame
+ *
+ * @param samples FFT_SIZE offset-free samples (see agc_process)
+ * @param work FFT_SIZE int16 scratch buffer (FFT_SIZE/2 packed complex values)
+ * @param mag Output, FFT_SIZE/2 magnitudes on the same scale as the float path
+ * @param gain Normalisation applied to every magnitude
+ * @return false if the esp-dsp kernel rejected the transform (logged)
+ */
+bool fft_q15_analyze(const int16_t *samples, int16_t *work, float *mag, float gain);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Compile-time FFT tables
+ *
+ * Every table the analysis needs for an N-point window is generated by
+ * constexpr functions, so it lands in rodata (flash) instead of being
+ * malloc'd and computed at boot. Trig is evaluated in double with a
+ * Taylor series, then rounded to the table type.
+ *
+ * All loops over these tables take N as a template parameter, so trip
+ * counts are constants the compiler can unroll.
+ */
+namespace fft_tables {
+
+constexpr double kPi = 3.14159265358979323846;
+
+constexpr double sin_cx(double x)
+{
+    while (x > kPi) x -= 2.0 * kPi;
+    while (x < -kPi) x += 2.0 * kPi;
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 16; n++) {
+        term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double cos_cx(double x)
+{
+    return sin_cx(x + kPi / 2.0);
+}
+
+constexpr int16_t to_q15(double v)
+{
+    double scaled = v * 32767.0;
+    return (int16_t)(scaled >= 0.0 ? scaled + 0.5 : scaled - 0.5);
+}
+
+constexpr size_t bit_reverse_index(size_t i, size_t bits)
+{
+    size_t r = 0;
+    for (size_t b = 0; b < bits; b++) {
+        r = (r << 1) | ((i >> b) & 1);
+    }
+    return r;
+}
+
+constexpr size_t log2_cx(size_t n)
+{
+    size_t bits = 0;
+    while ((size_t(1) << bits) < n) bits++;
+    return bits;
+}
+
+// (cos, sin) of 2*pi*k/N for k < N/2, for the packed real-FFT split step
+template <typename T, size_t N>
+constexpr std::array<T, N> make_split_twiddles()
+{
+    std::array<T, N> w{};
+    for (size_t k = 0; k < N / 2; k++) {
+        double phase = 2.0 * kPi * (double)k / (double)N;
+        if constexpr (sizeof(T) == sizeof(int16_t)) {
+            w[2 * k] = to_q15(cos_cx(phase));
+            w[2 * k + 1] = to_q15(sin_cx(phase));
+        } else {
+            w[2 * k] = (T)cos_cx(phase);
+            w[2 * k + 1] = (T)sin_cx(phase);
+        }
+    }
+    return w;
+}
+
+template <size_t M>
+constexpr size_t bit_reverse_pair_count()
+{
+    size_t count = 0;
+    for (size_t i = 0; i < M; i++) {
+        if (i < bit_reverse_index(i, log2_cx(M))) count++;
+    }
+    return count;
+}
+
+// Index pairs (i, rev(i)) with i < rev(i) for an M-point complex reorder
+template <size_t M>
+constexpr std::array<uint16_t, 2 * bit_reverse_pair_count<M>()> make_bit_reverse_pairs()
+{
+    std::array<uint16_t, 2 * bit_reverse_pair_count<M>()> pairs{};
+    size_t p = 0;
+    for (size_t i = 0; i < M; i++) {
+        size_t r = bit_reverse_index(i, log2_cx(M));
+        if (i < r) {
+            pairs[p++] = (uint16_t)i;
+            pairs[p++] = (uint16_t)r;
+        }
+    }
+    return pairs;
+}
+
+enum class Window { Hann, Blackman };
+
+// Same definitions as dsps_wind_hann_f32 / dsps_wind_blackman_f32
+constexpr double window_value(Window type, size_t i, size_t n)
+{
+    double x = 2.0 * kPi * (double)i / (double)(n - 1);
+    return (type == Window::Hann) ? 0.5 - 0.5 * cos_cx(x)
+                                  : 0.42 - 0.5 * cos_cx(x) + 0.08 * cos_cx(2.0 * x);
+}
+
+// Factor that brings the window to unit coherent gain (sum == N)
+template <size_t N>
+constexpr double window_gain(Window type)
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < N; i++) {
+        sum += window_value(type, i, N);
+    }
+    return (double)N / sum;
+}
+
+template <size_t N>
+constexpr std::array<float, N> make_window(Window type)
+{
+    std::array<float, N> w{};
+    const double gain = window_gain<N>(type);
+    for (size_t i = 0; i < N; i++) {
+        w[i] = (float)(window_value(type, i, N) * gain);
+    }
+    return w;
+}
+
+// Raw window (peak <= 1) in Q15; the Q15 backend folds the gain into its output scale
+template <size_t N>
+constexpr std::array<int16_t, N> make_window_q15(Window type)
+{
+    std::array<int16_t, N> w{};
+    for (size_t i = 0; i < N; i++) {
+        w[i] = to_q15(window_value(type, i, N));
+    }
+    return w;
+}
+
+/**
+ * @brief All tables for an N-point real-input analysis window
+ *
+ * The window runs as an N/2-point complex FFT on packed input, so the
+ * reorder table covers N/2 points. The radix-2 twiddles are not here:
+ * esp-dsp's kernels only run on the table dsps_fft2r_init_fc32/sc16()
+ * builds, so initialize_fft() has esp-dsp allocate it.
+ */
+template <size_t N>
+struct Tables {
+    static_assert(N >= 16 && N <= 4096 && (N & (N - 1)) == 0, "FFT size must be a power of two, 16-4096");
+
+    static constexpr std::array<float, N> split_fc32 = make_split_twiddles<float, N>();
+    static constexpr std::array<int16_t, N> split_q15 = make_split_twiddles<int16_t, N>();
+    static constexpr auto bit_reverse_packed = make_bit_reverse_pairs<N / 2>();
+    static constexpr auto bit_reverse_full = make_bit_reverse_pairs<N>();
+
+    alignas(16) static constexpr std::array<float, N> hann = make_window<N>(Window::Hann);
+    alignas(16) static constexpr std::array<float, N> blackman = make_window<N>(Window::Blackman);
+    static constexpr std::array<int16_t, N> hann_q15 = make_window_q15<N>(Window::Hann);
+    static constexpr std::array<int16_t, N> blackman_q15 = make_window_q15<N>(Window::Blackman);
+    static constexpr float hann_gain = (float)window_gain<N>(Window::Hann);
+    static constexpr float blackman_gain = (float)window_gain<N>(Window::Blackman);
+};
+
+// Swap interleaved complex values into bit-reversed order using a pair table
+template <typename T, size_t P>
+inline void bit_reverse(T *data, const std::array<uint16_t, P> &pairs)
+{
+    for (size_t p = 0; p < P; p += 2) {
+        T *a = data + 2 * pairs[p];
+        T *b = data + 2 * pairs[p + 1];
+        T re = a[0];
+        T im = a[1];
+        a[0] = b[0];
+        a[1] = b[1];
+        b[0] = re;
+        b[1] = im;
+    }
+}
+
+} // namespace fft_tables
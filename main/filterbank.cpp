@@ -0,0 +1,118 @@
+#include "filterbank.h"
+#include "FFT.h"
+#include "spectrum_kernels.h"
+#include <math.h>
+
+// Half-overlapping triangles touch each bin at most twice, plus one forced
+// bin per band for bands narrower than a bin
+#define FILTERBANK_MAX_WEIGHTS (FFT_SIZE + FILTERBANK_MAX_BANDS)
+
+typedef struct {
+    uint16_t first_bin;   // First bin with a non-zero weight
+    uint16_t bin_count;   // Number of consecutive weighted bins
+    uint16_t weight_offset;
+    float norm;           // 1 / sum of the band's weights
+} band_span_t;
+
+static band_span_t spans[FILTERBANK_MAX_BANDS];
+alignas(16) static float weights[FILTERBANK_MAX_WEIGHTS];
+alignas(16) static float squared[FFT_SIZE / 2];   // filterbank_apply() scratch
+static uint16_t bins_used = 0;                   // One past the highest weighted bin
+static float centers[FILTERBANK_MAX_BANDS];
+static uint8_t band_count = 0;
+
+static float to_scale(float hz, filterbank_scale_t scale) {
+    return (scale == FILTERBANK_SCALE_MEL) ? 2595.0f * log10f(1.0f + hz / 700.0f) : logf(hz);
+}
+
+static float from_scale(float value, filterbank_scale_t scale) {
+    return (scale == FILTERBANK_SCALE_MEL) ? 700.0f * (powf(10.0f, value / 2595.0f) - 1.0f) : expf(value);
+}
+
+bool filterbank_init(uint8_t num_bands, filterbank_scale_t scale, float min_freq, float max_freq,
+                     uint16_t num_bins, float bin_hz) {
+    if (num_bands == 0 || num_bands > FILTERBANK_MAX_BANDS || num_bins > FFT_SIZE / 2 ||
+        min_freq <= 0.0f || max_freq <= min_freq || bin_hz <= 0.0f) {
+        return false;
+    }
+
+    // num_bands + 2 edge frequencies, evenly spaced on the chosen scale
+    float lo = to_scale(min_freq, scale);
+    float step = (to_scale(max_freq, scale) - lo) / (num_bands + 1);
+
+    uint16_t offset = 0;
+    uint16_t used = 0;
+    for (int b = 0; b < num_bands; b++) {
+        float lower = from_scale(lo + step * b, scale);
+        float center = from_scale(lo + step * (b + 1), scale);
+        float upper = from_scale(lo + step * (b + 2), scale);
+        centers[b] = center;
+
+        int first = (int)ceilf(lower / bin_hz);
+        int last = (int)floorf(upper / bin_hz);
+        if (first < 1) first = 1;                 // Never include DC
+        if (last > num_bins - 1) last = num_bins - 1;
+
+        band_span_t *span = &spans[b];
+        span->weight_offset = offset;
+        span->first_bin = 0;
+        span->bin_count = 0;
+        float sum = 0.0f;
+
+        for (int i = first; i <= last; i++) {
+            float f = i * bin_hz;
+            float w = (f <= center) ? (f - lower) / (center - lower) : (upper - f) / (upper - center);
+            if (w <= 0.0f) {
+                if (span->bin_count == 0) continue;
+                break;
+            }
+            if (span->bin_count == 0) span->first_bin = (uint16_t)i;
+            weights[offset + span->bin_count++] = w;
+            sum += w;
+        }
+
+        // Band narrower than a bin: fall back to the bin nearest its centre
+        if (span->bin_count == 0) {
+            int nearest = (int)lrintf(center / bin_hz);
+            if (nearest < 1) nearest = 1;
+            if (nearest > num_bins - 1) nearest = num_bins - 1;
+            span->first_bin = (uint16_t)nearest;
+            span->bin_count = 1;
+            weights[offset] = 1.0f;
+            sum = 1.0f;
+        }
+
+        span->norm = 1.0f / sum;
+        offset += span->bin_count;
+        if (span->first_bin + span->bin_count > used) {
+            used = span->first_bin + span->bin_count;
+        }
+    }
+
+    band_count = num_bands;
+    bins_used = used;
+    return true;
+}
+
+void filterbank_apply(const float *magnitudes, float *bands) {
+    for (int i = 0; i < bins_used; i++) {
+        squared[i] = magnitudes[i] * magnitudes[i];
+    }
+    filterbank_apply_power(squared, bands);
+}
+
+void filterbank_apply_power(const float *power, float *bands) {
+    for (int b = 0; b < band_count; b++) {
+        const band_span_t *span = &spans[b];
+        float sum = spectrum_dot(weights + span->weight_offset, power + span->first_bin, span->bin_count);
+        bands[b] = sqrtf(sum * span->norm);
+    }
+}
+
+uint8_t filterbank_get_band_count(void) {
+    return band_count;
+}
+
+float filterbank_get_band_center(uint8_t band) {
+    return (band < band_count) ? centers[band] : 0.0f;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define FILTERBANK_MAX_BANDS 32
+#define FILTERBANK_DEFAULT_BANDS 16
+#define FILTERBANK_MIN_FREQ 40.0f    // Lower edge of the first band (Hz)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Spacing of the band centre frequencies
+ */
+typedef enum {
+    FILTERBANK_SCALE_LOG,   // Equal ratio between neighbouring bands
+    FILTERBANK_SCALE_MEL    // Mel scale (closer to linear below ~700 Hz)
+} filterbank_scale_t;
+
+/**
+ * @brief Build the triangular band weight table
+ *
+ * Bands overlap by half and cover min_freq up to max_freq. Each band's
+ * weights are stored as a contiguous run of bins so applying the bank only
+ * touches non-zero weights. Bands narrower than one FFT bin still get the
+ * nearest bin so no band is ever empty.
+ *
+ * @param num_bands Number of bands (1 to FILTERBANK_MAX_BANDS)
+ * @param scale Band spacing
+ * @param min_freq Lower edge of the first band in Hz
+ * @param max_freq Upper edge of the last band in Hz
+ * @param num_bins Number of magnitude bins the bank will be applied to
+ * @param bin_hz Width of one magnitude bin in Hz
+ * @return true on success, false if the arguments are out of range
+ */
+bool filterbank_init(uint8_t num_bands, filterbank_scale_t scale, float min_freq, float max_freq,
+                     uint16_t num_bins, float bin_hz);
+
+/**
+ * @brief Reduce a magnitude spectrum to per-band levels
+ *
+ * Each output is the RMS magnitude of the bins under the band's weights.
+ *
+ * @param magnitudes num_bins magnitudes
+ * @param bands Output, filterbank_get_band_count() values
+ */
+void filterbank_apply(const float *magnitudes, float *bands);
+
+/**
+ * @brief Same as filterbank_apply() from squared magnitudes
+ *
+ * Saves squaring the spectrum again when the caller already has it.
+ *
+ * @param power num_bins squared magnitudes
+ * @param bands Output, filterbank_get_band_count() values
+ */
+void filterbank_apply_power(const float *power, float *bands);
+
+/**
+ * @brief Number of bands in the current table
+ */
+uint8_t filterbank_get_band_count(void);
+
+/**
+ * @brief Centre frequency of a band in Hz
+ */
+float filterbank_get_band_center(uint8_t band);
+
+#ifdef __cplusplus
+}
+#endif
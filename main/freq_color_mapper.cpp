@@ -0,0 +1,274 @@
+#include "freq_color_mapper.h"
+#include <array>
+#include <atomic>
+#include <string.h>
+
+#define DEFAULT_MIN_HZ 50.0f
+#define DEFAULT_MAX_HZ 5000.0f
+#define FREQ_Q 4   // Frequencies in 1/16 Hz
+
+/**
+ * Palettes are 256-entry RGB tables. The built-in ones are generated from
+ * a few gradient stops by constexpr code, so they sit in flash; uploaded
+ * ones are built by the same code at run time into RAM slots.
+ *
+ * Frequencies are converted to Q4 (1/16 Hz) and their log2 is taken in Q8
+ * from the position of the top bit plus a 256-entry mantissa table, which
+ * makes the log-scale palette index a subtraction, a multiply and a shift.
+ */
+namespace {
+
+typedef std::array<rgb_t, PALETTE_SIZE> PaletteTable;
+
+constexpr uint8_t lerp8(uint8_t a, uint8_t b, int t, int span)
+{
+    return (uint8_t)(a + ((b - a) * t + (b >= a ? span / 2 : -span / 2)) / span);
+}
+
+constexpr void fill_gradient(rgb_t *out, const palette_stop_t *stops, int count)
+{
+    for (int i = 0; i < PALETTE_SIZE; i++) {
+        int s = 0;
+        while (s + 1 < count && stops[s + 1].pos <= i) s++;
+        const palette_stop_t &a = stops[s];
+        if (i <= a.pos || s + 1 == count) {
+            out[i] = a.color;
+            continue;
+        }
+        const palette_stop_t &b = stops[s + 1];
+        int t = i - a.pos;
+        int span = b.pos - a.pos;
+        out[i] = rgb_t{lerp8(a.color.r, b.color.r, t, span), lerp8(a.color.g, b.color.g, t, span),
+                       lerp8(a.color.b, b.color.b, t, span)};
+    }
+}
+
+template <size_t N>
+constexpr PaletteTable make_gradient(const palette_stop_t (&stops)[N])
+{
+    PaletteTable table{};
+    fill_gradient(table.data(), stops, (int)N);
+    return table;
+}
+
+// log2(1 + i/256) in Q8
+constexpr std::array<uint8_t, 256> make_log2_mantissa()
+{
+    std::array<uint8_t, 256> t{};
+    for (int i = 0; i < 256; i++) {
+        // ln(y) = 2 * atanh(z) with z = (y - 1) / (y + 1), which converges fast for y in [1, 2)
+        double y = 1.0 + i / 256.0;
+        double z = (y - 1.0) / (y + 1.0);
+        double term = z;
+        double sum = 0.0;
+        for (int k = 0; k < 12; k++) {
+            sum += term / (2 * k + 1);
+            term *= z * z;
+        }
+        double log2y = 2.0 * sum / 0.69314718055994531;
+        int q = (int)(log2y * 256.0 + 0.5);
+        t[i] = (uint8_t)(q > 255 ? 255 : q);
+    }
+    return t;
+}
+
+// Square law: quiet sounds fall off quickly, loud ones reach full scale
+constexpr std::array<uint8_t, 256> make_brightness_curve()
+{
+    std::array<uint8_t, 256> t{};
+    for (int i = 0; i < 256; i++) {
+        t[i] = (uint8_t)((i * i + 127) / 255);
+    }
+    return t;
+}
+
+constexpr palette_stop_t kSpectrumStops[] = {
+    {0, {255, 0, 0}}, {128, {0, 255, 0}}, {255, {0, 0, 255}},
+};
+constexpr palette_stop_t kRainbowStops[] = {
+    {0, {255, 0, 0}}, {51, {255, 255, 0}}, {102, {0, 255, 0}},
+    {153, {0, 255, 255}}, {204, {0, 0, 255}}, {255, {255, 0, 255}},
+};
+constexpr palette_stop_t kFireStops[] = {
+    {0, {32, 0, 0}}, {96, {255, 0, 0}}, {160, {255, 96, 0}}, {224, {255, 200, 0}}, {255, {255, 255, 160}},
+};
+constexpr palette_stop_t kOceanStops[] = {
+    {0, {0, 0, 64}}, {96, {0, 32, 255}}, {176, {0, 192, 192}}, {255, {160, 255, 255}},
+};
+constexpr palette_stop_t kForestStops[] = {
+    {0, {0, 48, 0}}, {112, {0, 192, 32}}, {192, {160, 255, 0}}, {255, {255, 224, 64}},
+};
+
+constexpr PaletteTable kSpectrum = make_gradient(kSpectrumStops);
+constexpr PaletteTable kRainbow = make_gradient(kRainbowStops);
+constexpr PaletteTable kFire = make_gradient(kFireStops);
+constexpr PaletteTable kOcean = make_gradient(kOceanStops);
+constexpr PaletteTable kForest = make_gradient(kForestStops);
+constexpr std::array<uint8_t, 256> kLog2Mantissa = make_log2_mantissa();
+constexpr std::array<uint8_t, 256> kBrightnessCurve = make_brightness_curve();
+
+struct BuiltinPalette {
+    const char *name;
+    const PaletteTable *table;
+};
+
+constexpr BuiltinPalette kBuiltin[] = {
+    {"spectrum", &kSpectrum}, {"rainbow", &kRainbow}, {"fire", &kFire}, {"ocean", &kOcean}, {"forest", &kForest},
+};
+constexpr int kBuiltinCount = sizeof(kBuiltin) / sizeof(kBuiltin[0]);
+
+static_assert(kSpectrum[0].r == 255 && kSpectrum[128].g == 255 && kSpectrum[255].b == 255,
+              "Gradient stops must land exactly");
+
+// log2(x) in Q8, x > 0
+constexpr uint32_t log2_q8(uint32_t x)
+{
+    int msb = 31 - __builtin_clz(x);
+    uint32_t mantissa = (msb >= 8) ? (x >> (msb - 8)) & 0xFF : (x << (8 - msb)) & 0xFF;
+    return (uint32_t)msb * 256 + kLog2Mantissa[mantissa];
+}
+
+constexpr uint32_t to_freq_q(float hz)
+{
+    float q = hz * (1 << FREQ_Q);
+    return q < 1.0f ? 1 : (uint32_t)q;
+}
+
+constexpr uint32_t pack_range(float min_hz, float max_hz)
+{
+    uint32_t lo = log2_q8(to_freq_q(min_hz));
+    uint32_t span = log2_q8(to_freq_q(max_hz)) - lo;
+    uint32_t scale = ((uint32_t)(PALETTE_SIZE - 1) << 16) / span;
+    return (scale << 16) | lo;
+}
+
+PaletteTable user_tables[PALETTE_MAX_USER];
+char user_names[PALETTE_MAX_USER][PALETTE_NAME_LEN];
+int user_count = 0;
+
+// Read by the render task, written by the web server. Replacing the active
+// user palette in place can show one frame with a mix of old and new colours.
+std::atomic<const rgb_t *> active_table{kSpectrum.data()};
+std::atomic<int> active_index{0};
+
+// Low half: log2 of the minimum frequency (Q8 of the Q4 value); high half:
+// palette index per Q8 log2 step, in Q16. Packed so a reader never sees a
+// half-updated range.
+std::atomic<uint32_t> range_word{pack_range(DEFAULT_MIN_HZ, DEFAULT_MAX_HZ)};
+float range_min_hz = DEFAULT_MIN_HZ;
+float range_max_hz = DEFAULT_MAX_HZ;
+
+const PaletteTable *table_at(int index)
+{
+    if (index < kBuiltinCount) {
+        return kBuiltin[index].table;
+    }
+    return &user_tables[index - kBuiltinCount];
+}
+
+} // namespace
+
+rgb_t map_frequency_to_color(float freq, float magnitude) {
+    const rgb_t *table = active_table.load(std::memory_order_acquire);
+    uint32_t range = range_word.load(std::memory_order_relaxed);
+    uint32_t lo = range & 0xFFFF;
+    uint32_t scale = range >> 16;
+
+    uint32_t l = log2_q8(to_freq_q(freq));
+    uint32_t index = (l <= lo) ? 0 : ((l - lo) * scale) >> 16;
+    if (index > PALETTE_SIZE - 1) index = PALETTE_SIZE - 1;
+
+    // Magnitude is normalised to 0-1 by the AGC
+    int level = (int)(magnitude * 255.0f + 0.5f);
+    if (level > 255) level = 255;
+    if (level < 0) level = 0;
+    uint32_t brightness = kBrightnessCurve[level];
+
+    rgb_t c = table[index];
+    return rgb_t{(uint8_t)((c.r * brightness + 127) / 255), (uint8_t)((c.g * brightness + 127) / 255),
+                 (uint8_t)((c.b * brightness + 127) / 255)};
+}
+
+int palette_count(void) {
+    return kBuiltinCount + user_count;
+}
+
+const char *palette_name(int index) {
+    if (index < 0 || index >= palette_count()) {
+        return NULL;
+    }
+    return (index < kBuiltinCount) ? kBuiltin[index].name : user_names[index - kBuiltinCount];
+}
+
+int palette_find(const char *name) {
+    for (int i = 0; i < palette_count(); i++) {
+        if (strcmp(palette_name(i), name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool palette_select(int index) {
+    if (index < 0 || index >= palette_count()) {
+        return false;
+    }
+    active_table.store(table_at(index)->data(), std::memory_order_release);
+    active_index.store(index, std::memory_order_relaxed);
+    return true;
+}
+
+int palette_get_active(void) {
+    return active_index.load(std::memory_order_relaxed);
+}
+
+int palette_upload(const char *name, const palette_stop_t *stops, int count) {
+    size_t name_len = name ? strlen(name) : 0;
+    if (name_len == 0 || name_len >= PALETTE_NAME_LEN || count < 1 || count > PALETTE_MAX_STOPS) {
+        return -1;
+    }
+    for (int i = 1; i < count; i++) {
+        if (stops[i].pos <= stops[i - 1].pos) {
+            return -1;
+        }
+    }
+
+    int index = palette_find(name);
+    if (index >= 0 && index < kBuiltinCount) {
+        return -1;
+    }
+    if (index < 0) {
+        if (user_count == PALETTE_MAX_USER) {
+            return -1;
+        }
+        index = kBuiltinCount + user_count;
+    }
+
+    int slot = index - kBuiltinCount;
+    fill_gradient(user_tables[slot].data(), stops, count);
+    if (slot == user_count) {
+        memcpy(user_names[slot], name, name_len + 1);
+        user_count++;
+    }
+    return index;
+}
+
+bool palette_range_valid(float min_hz, float max_hz) {
+    // At least an octave, so the index scale fits in 16 bits
+    return min_hz >= 1.0f && max_hz >= 2.0f * min_hz && max_hz <= 100000.0f;
+}
+
+bool palette_set_range(float min_hz, float max_hz) {
+    if (!palette_range_valid(min_hz, max_hz)) {
+        return false;
+    }
+    range_min_hz = min_hz;
+    range_max_hz = max_hz;
+    range_word.store(pack_range(min_hz, max_hz), std::memory_order_relaxed);
+    return true;
+}
+
+void palette_get_range(float *min_hz, float *max_hz) {
+    *min_hz = range_min_hz;
+    *max_hz = range_max_hz;
+}
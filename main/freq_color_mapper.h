@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 
 typedef struct {
@@ -12,9 +13,55 @@ typedef struct {
 extern "C" {
 #endif
 
-// Map frequency (Hz) and magnitude to color + brightness
+#define PALETTE_SIZE 256
+#define PALETTE_MAX_USER 4       // Uploaded palettes kept alongside the built-in ones
+#define PALETTE_MAX_STOPS 16
+#define PALETTE_NAME_LEN 16      // Including the terminator
+
+// One colour of a gradient; pos is the palette index (0-255) it sits at
+typedef struct {
+    uint8_t pos;
+    rgb_t color;
+} palette_stop_t;
+
+/**
+ * @brief Map frequency (Hz) and normalised magnitude (0-1) to a colour
+ *
+ * The frequency picks an entry of the active 256-colour palette on a log
+ * scale between the range set by palette_set_range(), and the magnitude
+ * scales it through a square-law brightness curve. Both are table
+ * lookups; there is no per-call float maths beyond the two conversions
+ * to fixed point.
+ */
 rgb_t map_frequency_to_color(float freq, float magnitude);
 
+// Palettes are numbered built-in first, then uploaded ones in upload order
+int palette_count(void);
+const char *palette_name(int index);
+int palette_find(const char *name);   // -1 if there is none by that name
+
+bool palette_select(int index);
+int palette_get_active(void);
+
+/**
+ * @brief Build a palette from gradient stops and add it to the user slots
+ *
+ * Colours are interpolated linearly between stops, which must be in
+ * increasing position order; the first and last colours extend to the
+ * ends. Uploading under an existing user palette's name replaces it.
+ * Uploaded palettes live in RAM and are gone after a reboot.
+ *
+ * @return The palette's index, or -1 if the stops or name are invalid, the
+ *         name belongs to a built-in palette, or every slot is taken
+ */
+int palette_upload(const char *name, const palette_stop_t *stops, int count);
+
+// Frequencies mapped onto the first and last palette entries: at least an
+// octave apart, from 1 Hz to 100 kHz
+bool palette_range_valid(float min_hz, float max_hz);
+bool palette_set_range(float min_hz, float max_hz);
+void palette_get_range(float *min_hz, float *max_hz);
+
 #ifdef __cplusplus
 }
 #endif
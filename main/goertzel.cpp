@@ -0,0 +1,103 @@
+#include "goertzel.h"
+#include <math.h>
+#include <string.h>
+
+typedef struct {
+    float freq_hz;
+    float coeff;    // 2 * cos(2 * pi * f / fs)
+    float s1;
+    float s2;
+} goertzel_filter_t;
+
+static goertzel_filter_t filters[GOERTZEL_MAX_FILTERS];
+static uint8_t filter_count = 0;
+static float window[GOERTZEL_MAX_BLOCK];
+static uint16_t block_size = 0;
+static uint16_t block_pos = 0;
+static float magnitudes[GOERTZEL_MAX_FILTERS];
+
+bool goertzel_bank_init(const float *freqs_hz, uint8_t count, float sample_rate_hz, uint16_t block) {
+    if (count == 0 || count > GOERTZEL_MAX_FILTERS || block < 2 || block > GOERTZEL_MAX_BLOCK ||
+        sample_rate_hz <= 0.0f) {
+        return false;
+    }
+
+    for (int i = 0; i < count; i++) {
+        filters[i].freq_hz = freqs_hz[i];
+        filters[i].coeff = 2.0f * cosf(2.0f * (float)M_PI * freqs_hz[i] / sample_rate_hz);
+        filters[i].s1 = 0.0f;
+        filters[i].s2 = 0.0f;
+    }
+
+    // Hann at unit coherent gain: peak magnitude of an amplitude-A tone is A * block / 2
+    for (int i = 0; i < block; i++) {
+        window[i] = 1.0f - cosf(2.0f * (float)M_PI * i / (block - 1));
+    }
+
+    filter_count = count;
+    block_size = block;
+    block_pos = 0;
+    memset(magnitudes, 0, sizeof(magnitudes));
+    return true;
+}
+
+void goertzel_bank_reset(void) {
+    for (int i = 0; i < filter_count; i++) {
+        filters[i].s1 = 0.0f;
+        filters[i].s2 = 0.0f;
+    }
+    block_pos = 0;
+}
+
+bool goertzel_bank_push(int16_t sample) {
+    if (filter_count == 0) {
+        return false;
+    }
+
+    float x = (float)sample * window[block_pos];
+
+    for (int i = 0; i < filter_count; i++) {
+        goertzel_filter_t *f = &filters[i];
+        float s0 = x + f->coeff * f->s1 - f->s2;
+        f->s2 = f->s1;
+        f->s1 = s0;
+    }
+
+    if (++block_pos < block_size) {
+        return false;
+    }
+
+    for (int i = 0; i < filter_count; i++) {
+        goertzel_filter_t *f = &filters[i];
+        float power = f->s1 * f->s1 + f->s2 * f->s2 - f->coeff * f->s1 * f->s2;
+        magnitudes[i] = sqrtf(power > 0.0f ? power : 0.0f);
+        f->s1 = 0.0f;
+        f->s2 = 0.0f;
+    }
+    block_pos = 0;
+    return true;
+}
+
+bool goertzel_bank_push_block(const int16_t *samples, size_t len) {
+    bool completed = false;
+    for (size_t i = 0; i < len; i++) {
+        completed |= goertzel_bank_push(samples[i]);
+    }
+    return completed;
+}
+
+void goertzel_bank_get_magnitudes(float *out) {
+    memcpy(out, magnitudes, filter_count * sizeof(magnitudes[0]));
+}
+
+uint8_t goertzel_bank_get_count(void) {
+    return filter_count;
+}
+
+uint16_t goertzel_bank_get_block_size(void) {
+    return block_size;
+}
+
+float goertzel_bank_get_frequency(uint8_t index) {
+    return (index < filter_count) ? filters[index].freq_hz : 0.0f;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define GOERTZEL_MAX_FILTERS 16
+#define GOERTZEL_MAX_BLOCK 512
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Configure the Goertzel filter bank
+ *
+ * Each filter tracks one frequency over blocks of block_size samples.
+ * Samples can be pushed one at a time as they arrive, so the work is
+ * spread over the capture period instead of done in one burst. A Hann
+ * window (scaled to unit coherent gain) is applied once per sample and
+ * shared by all filters. Input must already be offset-free (agc_process).
+ * A tone of amplitude A reads A * block_size / 2, as in an FFT of the
+ * same length.
+ *
+ * @param freqs_hz Centre frequency of each filter
+ * @param count Number of filters (1 to GOERTZEL_MAX_FILTERS)
+ * @param sample_rate_hz Sample rate of the pushed samples
+ * @param block_size Samples per measurement (2 to GOERTZEL_MAX_BLOCK)
+ * @return true on success
+ */
+bool goertzel_bank_init(const float *freqs_hz, uint8_t count, float sample_rate_hz, uint16_t block_size);
+
+/**
+ * @brief Drop the partially filled block
+ *
+ * Keeps the filter frequencies and the last completed magnitudes.
+ */
+void goertzel_bank_reset(void);
+
+/**
+ * @brief Feed one sample
+ *
+ * @param sample Offset-free sample
+ * @return true if this sample completed a block and new magnitudes are available
+ */
+bool goertzel_bank_push(int16_t sample);
+
+/**
+ * @brief Feed several samples
+ *
+ * @return true if at least one block completed
+ */
+bool goertzel_bank_push_block(const int16_t *samples, size_t len);
+
+/**
+ * @brief Magnitudes from the most recently completed block
+ *
+ * @param out goertzel_bank_get_count() values, in filter order
+ */
+void goertzel_bank_get_magnitudes(float *out);
+
+uint8_t goertzel_bank_get_count(void);
+uint16_t goertzel_bank_get_block_size(void);
+float goertzel_bank_get_frequency(uint8_t index);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,261 @@
+#include "i2s_capture.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "driver/i2s_std.h"
+#include "driver/i2s_pdm.h"
+#include "soc/soc_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "i2s_capture";
+
+// Mic clocks stop working below roughly 1 MHz, i.e. 16 kHz at 64x oversampling
+#define I2S_CAPTURE_MIN_RATE_HZ 16000
+
+// DMA: descriptors of I2S_DMA_FRAMES samples each. At 48 kHz this holds
+// about 40 ms of audio before the oldest descriptor is overwritten.
+#define I2S_DMA_DESC    8
+#define I2S_DMA_FRAMES  240
+
+// Samples pulled from the DMA buffers per driver read
+#define I2S_READ_SAMPLES 256
+
+// PDM mics come out of the peripheral as 16-bit PCM. Standard I2S mics send
+// 24 bits left-justified in a 32-bit slot; they are kept at 24 bits while
+// decimating and brought to 16-bit full scale on output.
+#if CONFIG_AUDIO_I2S_MODE_PDM
+typedef int16_t raw_sample_t;
+#define RAW_TO_ACC(x)   ((int32_t)(x))
+#define ACC_EXTRA_BITS  0
+#define I2S_MODE_NAME   "PDM"
+#else
+typedef int32_t raw_sample_t;
+#define RAW_TO_ACC(x)   ((x) >> 8)
+#define ACC_EXTRA_BITS  8
+#define I2S_MODE_NAME   "standard"
+#endif
+
+// Output is 12-bit, as the analysis expects from every source
+#define OUTPUT_LIMIT 2047
+
+static i2s_chan_handle_t rx_handle = NULL;
+static uint16_t decimation = 1;
+static uint32_t hw_rate_hz = 0;
+
+static raw_sample_t raw_buf[I2S_READ_SAMPLES];
+
+// Partial decimation state carried across reads
+static int32_t acc_sum = 0;
+static uint16_t acc_count = 0;
+
+// Counters
+static uint32_t frame_count = 0;
+static volatile uint32_t overrun_count = 0;
+static uint32_t underrun_count = 0;
+
+// Called from ISR context when a DMA descriptor is overwritten before it was read
+static bool IRAM_ATTR on_recv_q_ovf(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    overrun_count = overrun_count + 1;
+    return false;
+}
+
+static esp_err_t init_mode(uint32_t rate_hz)
+{
+#if CONFIG_AUDIO_I2S_MODE_PDM
+#if SOC_I2S_SUPPORTS_PDM_RX
+    i2s_pdm_rx_config_t pdm_cfg = {
+        .clk_cfg = I2S_PDM_RX_CLK_DEFAULT_CONFIG(rate_hz),
+        .slot_cfg = I2S_PDM_RX_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
+        .gpio_cfg = {
+            .clk = (gpio_num_t)CONFIG_AUDIO_I2S_CLK_GPIO,
+            .din = (gpio_num_t)CONFIG_AUDIO_I2S_DATA_GPIO,
+            .invert_flags = {
+                .clk_inv = false,
+            },
+        },
+    };
+    return i2s_channel_init_pdm_rx_mode(rx_handle, &pdm_cfg);
+#else
+    ESP_LOGE(TAG, "PDM receive is not supported on this chip");
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+#else
+    i2s_std_config_t std_cfg = {
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(rate_hz),
+        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_32BIT, I2S_SLOT_MODE_MONO),
+        .gpio_cfg = {
+            .mclk = I2S_GPIO_UNUSED,
+            .bclk = (gpio_num_t)CONFIG_AUDIO_I2S_CLK_GPIO,
+            .ws = (gpio_num_t)CONFIG_AUDIO_I2S_WS_GPIO,
+            .dout = I2S_GPIO_UNUSED,
+            .din = (gpio_num_t)CONFIG_AUDIO_I2S_DATA_GPIO,
+            .invert_flags = {
+                .mclk_inv = false,
+                .bclk_inv = false,
+                .ws_inv = false,
+            },
+        },
+    };
+    return i2s_channel_init_std_mode(rx_handle, &std_cfg);
+#endif
+}
+
+esp_err_t i2s_capture_init(uint32_t sample_rate_hz)
+{
+    if (rx_handle != NULL) {
+        ESP_LOGW(TAG, "I2S capture already running");
+        return ESP_OK;
+    }
+    if (sample_rate_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    decimation = 1;
+    while (sample_rate_hz * decimation < I2S_CAPTURE_MIN_RATE_HZ) {
+        decimation++;
+    }
+    hw_rate_hz = sample_rate_hz * decimation;
+
+    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_0, I2S_ROLE_MASTER);
+    chan_cfg.dma_desc_num = I2S_DMA_DESC;
+    chan_cfg.dma_frame_num = I2S_DMA_FRAMES;
+    esp_err_t ret = i2s_new_channel(&chan_cfg, NULL, &rx_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create I2S channel: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = init_mode(hw_rate_hz);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure I2S: %s", esp_err_to_name(ret));
+        i2s_del_channel(rx_handle);
+        rx_handle = NULL;
+        return ret;
+    }
+
+    i2s_event_callbacks_t cbs = {
+        .on_recv = NULL,
+        .on_recv_q_ovf = on_recv_q_ovf,
+        .on_sent = NULL,
+        .on_send_q_ovf = NULL,
+    };
+    ESP_ERROR_CHECK(i2s_channel_register_event_callback(rx_handle, &cbs, NULL));
+
+    acc_sum = 0;
+    acc_count = 0;
+
+    ret = i2s_channel_enable(rx_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start I2S: %s", esp_err_to_name(ret));
+        i2s_del_channel(rx_handle);
+        rx_handle = NULL;
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "I2S %s mic started: %lu Hz (hw %lu Hz, decimation %u)",
+             I2S_MODE_NAME, (unsigned long)sample_rate_hz, (unsigned long)hw_rate_hz, decimation);
+    return ESP_OK;
+}
+
+esp_err_t i2s_capture_read_frame(int16_t *out, size_t len, uint32_t timeout_ms)
+{
+    if (rx_handle == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    size_t filled = 0;
+    const int out_shift = ACC_EXTRA_BITS + CONFIG_AUDIO_I2S_SHIFT;
+
+    while (filled < len) {
+        // Only take what this frame needs; the rest stays queued in DMA
+        size_t want = (len - filled) * decimation - acc_count;
+        if (want > I2S_READ_SAMPLES) {
+            want = I2S_READ_SAMPLES;
+        }
+
+        int64_t remaining_us = deadline - esp_timer_get_time();
+        if (remaining_us < 0) {
+            remaining_us = 0;
+        }
+
+        size_t got_bytes = 0;
+        esp_err_t ret = i2s_channel_read(rx_handle, raw_buf, want * sizeof(raw_buf[0]), &got_bytes,
+                                         (uint32_t)(remaining_us / 1000));
+
+        // Decimate whatever arrived, even on a timeout. A failed frame's output
+        // is dropped (the caller restarts its history), so only a partial
+        // decimation sum carries over into the next frame.
+        for (size_t i = 0; i < got_bytes / sizeof(raw_buf[0]) && filled < len; i++) {
+            acc_sum += RAW_TO_ACC(raw_buf[i]);
+            if (++acc_count == decimation) {
+                int32_t v = (acc_sum / decimation) >> out_shift;
+                if (v > OUTPUT_LIMIT) v = OUTPUT_LIMIT;
+                if (v < -OUTPUT_LIMIT) v = -OUTPUT_LIMIT;
+                out[filled++] = (int16_t)v;
+                acc_sum = 0;
+                acc_count = 0;
+            }
+        }
+
+        if (ret == ESP_ERR_TIMEOUT || (got_bytes == 0 && remaining_us == 0)) {
+            if (filled < len) {
+                underrun_count++;
+                return ESP_ERR_TIMEOUT;
+            }
+        } else if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    frame_count++;
+    return ESP_OK;
+}
+
+esp_err_t i2s_capture_flush(void)
+{
+    if (rx_handle == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    acc_sum = 0;
+    acc_count = 0;
+
+    // No flush call for RX channels: drain without waiting
+    size_t got_bytes;
+    do {
+        got_bytes = 0;
+        i2s_channel_read(rx_handle, raw_buf, sizeof(raw_buf), &got_bytes, 0);
+    } while (got_bytes == sizeof(raw_buf));
+    return ESP_OK;
+}
+
+void i2s_capture_get_stats(audio_source_stats_t *out)
+{
+    out->frames = frame_count;
+    out->overruns = overrun_count;
+    out->underruns = underrun_count;
+    out->lost = 0;
+    out->hw_rate_hz = hw_rate_hz;
+}
+
+esp_err_t i2s_capture_deinit(void)
+{
+    if (rx_handle == NULL) {
+        return ESP_OK;
+    }
+    i2s_channel_disable(rx_handle);
+    esp_err_t ret = i2s_del_channel(rx_handle);
+    rx_handle = NULL;
+    return ret;
+}
+
+const audio_source_t i2s_audio_source = {
+    .name = "i2s",
+    .open = i2s_capture_init,
+    .read_frame = i2s_capture_read_frame,
+    .flush = i2s_capture_flush,
+    .close = i2s_capture_deinit,
+    .get_stats = i2s_capture_get_stats,
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <esp_err.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "audio_source.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start receiving from a digital microphone over I2S
+ *
+ * Depending on CONFIG_AUDIO_I2S_MODE_* the mic is either a PDM mic (clock
+ * and data pins, the I2S peripheral does the PDM-to-PCM conversion) or a
+ * standard I2S mic such as the INMP441 (bit clock, word select and data,
+ * 24-bit samples in 32-bit slots, left channel). Samples are moved into
+ * the channel's DMA descriptors in the background.
+ *
+ * Mic clocks have a lower limit, so below I2S_CAPTURE_MIN_RATE_HZ the
+ * interface runs at an integer multiple of the requested rate and the
+ * surplus samples are averaged away, as the ADC capture does.
+ *
+ * @param sample_rate_hz Output sample rate in Hz
+ * @return esp_err_t ESP_OK on success, otherwise error
+ */
+esp_err_t i2s_capture_init(uint32_t sample_rate_hz);
+
+/**
+ * @brief Block until the next len samples are available and copy them out
+ *
+ * Samples are scaled to a 12-bit swing around zero (shifted down by
+ * CONFIG_AUDIO_I2S_SHIFT from 16-bit full scale and clamped).
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_TIMEOUT on underrun
+ */
+esp_err_t i2s_capture_read_frame(int16_t *out, size_t len, uint32_t timeout_ms);
+
+/**
+ * @brief Discard everything queued in the DMA buffers
+ */
+esp_err_t i2s_capture_flush(void);
+
+void i2s_capture_get_stats(audio_source_stats_t *out);
+
+/**
+ * @brief Stop receiving and release the I2S channel
+ */
+esp_err_t i2s_capture_deinit(void);
+
+// The I2S microphone as an analysis audio source
+extern const audio_source_t i2s_audio_source;
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,9 +2,11 @@
 #include "driver/uart.h"
 #include "esp_log.h"
 #include "freq_color_mapper.h"
+#include "filterbank.h"
 // #include "freertos/FreeRTOS.h"
 // #include "freertos/task.h"
 #include <string.h>
+#include <math.h>
 
 static const char *TAG = "UART_TEST";
 
@@ -19,7 +21,9 @@ void uart_init(void) {
 
     ESP_ERROR_CHECK(uart_param_config(UART_PORT_NUM, &uart_config));
     ESP_ERROR_CHECK(uart_set_pin(UART_PORT_NUM, UART_TX_PIN, UART_RX_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
-    ESP_ERROR_CHECK(uart_driver_install(UART_PORT_NUM, UART_BUF_SIZE * 2, 0, 0, NULL, 0));
+    // A TX ring buffer, so a send only copies the line and returns instead of
+    // waiting for it to drain through the FIFO at 115200 baud
+    ESP_ERROR_CHECK(uart_driver_install(UART_PORT_NUM, UART_BUF_SIZE * 2, UART_BUF_SIZE, 0, NULL, 0));
 
     ESP_LOGI(TAG, "UART initialized on TX=%d, RX=%d", UART_TX_PIN, UART_RX_PIN);
 }
@@ -37,3 +41,14 @@ void jetson_send_color(rgb_t color) {
     snprintf(uart_msg, sizeof(uart_msg), "COLOR R:%d G:%d B:%d\n", color.r, color.g, color.b);
     uart_send(uart_msg);
 }
+
+void jetson_send_bands(const float *bands, int count) {
+    // "BANDS <n> <b0> ... <bn-1>\n", normalised levels sent as 0-255
+    char uart_msg[16 + FILTERBANK_MAX_BANDS * 12];
+    size_t len = snprintf(uart_msg, sizeof(uart_msg), "BANDS %d", count);
+    for (int i = 0; i < count && len + 12 < sizeof(uart_msg); i++) {
+        len += snprintf(uart_msg + len, sizeof(uart_msg) - len, " %ld", lrintf(fminf(bands[i], 1.0f) * 255.0f));
+    }
+    snprintf(uart_msg + len, sizeof(uart_msg) - len, "\n");
+    uart_send(uart_msg);
+}
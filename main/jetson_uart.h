@@ -19,6 +19,7 @@ void uart_init(void);
 void uart_send(const char *data);
 int uart_receive(char *data, size_t max_len);
 void jetson_send_color(rgb_t color);
+void jetson_send_bands(const float *bands, int count);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,486 @@
+#include "led_effects.h"
+#include "led_strip_control.h"
+#include "rolling_stats.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "led_effects";
+
+/**
+ * Effects run on the LED render task, one call per frame tick, with the
+ * state lock held. All maths is integer: positions and phases are Q8
+ * (256 per LED or per colour step), colours are blended with 0-256
+ * weights, and time comes in as the frame's esp_timer timestamp, so an
+ * effect looks the same at any frame rate. Twinkle and fire keep one
+ * byte of state per LED in their context.
+ */
+#define EFFECT_MAX_STEP_US 100000     // Longest time step one frame may take, e.g. after a mode switch
+#define EFFECT_COST_WINDOW 64
+#define FIRE_STEP_US 16667            // Simulation step at speed 128
+#define FIRE_MAX_STEPS 4              // Per frame, so a slow frame does not snowball
+
+struct EffectContext {
+    int effect;
+    uint8_t *cells;        // Twinkle levels or fire heat, one per LED
+    uint16_t cell_count;
+    uint32_t rng;
+    int64_t last_us;       // Previous frame, for effects that step in time
+    uint32_t carry_us;     // Fire time not yet simulated
+};
+
+typedef void (*EffectFn)(rgb_t *px, uint16_t n, int64_t now_us, uint32_t dt_us, const led_effect_params_t &p,
+                         EffectContext &ctx);
+
+namespace {
+
+inline uint8_t lerp8(uint8_t a, uint8_t b, uint32_t t)
+{
+    return (uint8_t)(a + ((((int32_t)b - (int32_t)a) * (int32_t)t) >> 8));
+}
+
+// t in 0-256
+inline rgb_t blend(rgb_t a, rgb_t b, uint32_t t)
+{
+    return rgb_t{lerp8(a.r, b.r, t), lerp8(a.g, b.g, t), lerp8(a.b, b.b, t)};
+}
+
+// l in 0-256
+inline rgb_t scale(rgb_t c, uint32_t l)
+{
+    return rgb_t{(uint8_t)((c.r * l) >> 8), (uint8_t)((c.g * l) >> 8), (uint8_t)((c.b * l) >> 8)};
+}
+
+// 0-255 to 0-256, so full scale is exact
+inline uint32_t weight(uint32_t v)
+{
+    return v + (v >> 7);
+}
+
+inline uint32_t xorshift(uint32_t &s)
+{
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+}
+
+// Units elapsed at units_per_s since boot, wrapping at 32 bits; in
+// milliseconds so the 64-bit product cannot overflow
+inline uint32_t phase(int64_t now_us, uint32_t units_per_s)
+{
+    return (uint32_t)((uint64_t)(now_us / 1000) * units_per_s / 1000);
+}
+
+inline uint8_t hash8(uint32_t x)
+{
+    x *= 0x9E3779B1u;
+    x ^= x >> 15;
+    x *= 0x85EBCA77u;
+    x ^= x >> 13;
+    return (uint8_t)(x >> 24);
+}
+
+// 3t^2 - 2t^3 on 0-255
+inline uint32_t smoothstep8(uint32_t t)
+{
+    return (t * t * (768 - 2 * t)) >> 16;
+}
+
+// Fully saturated hue wheel, 0-255
+inline rgb_t wheel(uint8_t h)
+{
+    if (h < 85) {
+        uint8_t f = (uint8_t)(h * 3);
+        return rgb_t{(uint8_t)(255 - f), f, 0};
+    }
+    if (h < 170) {
+        uint8_t f = (uint8_t)((h - 85) * 3);
+        return rgb_t{0, (uint8_t)(255 - f), f};
+    }
+    uint8_t f = (uint8_t)((h - 170) * 3);
+    return rgb_t{f, 0, (uint8_t)(255 - f)};
+}
+
+// One octave of 1D value noise, stepped along the strip
+struct NoiseOctave {
+    uint32_t pos;      // Q8 lattice position
+    uint32_t step;
+    uint32_t seed;
+    uint32_t cell = UINT32_MAX;
+    uint8_t a = 0;
+    uint8_t b = 0;
+
+    uint32_t next()
+    {
+        uint32_t c = pos >> 8;
+        if (c != cell) {
+            cell = c;
+            a = hash8(c ^ seed);
+            b = hash8((c + 1) ^ seed);
+        }
+        uint32_t v = lerp8(a, b, weight(smoothstep8(pos & 0xFF)));
+        pos += step;
+        return v;
+    }
+};
+
+} // namespace
+
+// Two-colour triangle wave, so the scroll wraps without a seam
+static void effect_gradient(rgb_t *px, uint16_t n, int64_t now_us, uint32_t dt_us, const led_effect_params_t &p,
+                            EffectContext &ctx)
+{
+    uint32_t repeats = 1 + p.size / 32;
+    uint32_t step = (repeats << 17) / n;   // 512 colour steps per repeat, Q8
+    uint32_t pos = phase(now_us, p.speed * 256u);
+    for (uint16_t i = 0; i < n; i++, pos += step) {
+        uint32_t u = (pos >> 8) & 511;
+        uint32_t t = u < 256 ? u : 511 - u;
+        px[i] = blend(p.color1, p.color2, weight(t));
+    }
+}
+
+static void effect_rainbow(rgb_t *px, uint16_t n, int64_t now_us, uint32_t dt_us, const led_effect_params_t &p,
+                           EffectContext &ctx)
+{
+    uint32_t repeats = 1 + p.size / 32;
+    uint32_t step = (repeats << 16) / n;   // Hue, Q8
+    uint32_t hue = phase(now_us, p.speed * 256u);
+    uint32_t white = 256 - weight(p.intensity);
+    for (uint16_t i = 0; i < n; i++, hue += step) {
+        rgb_t c = wheel((uint8_t)(hue >> 8));
+        px[i] = rgb_t{(uint8_t)(c.r + (((255 - c.r) * white) >> 8)), (uint8_t)(c.g + (((255 - c.g) * white) >> 8)),
+                      (uint8_t)(c.b + (((255 - c.b) * white) >> 8))};
+    }
+}
+
+// Blocks of color1 with a fading tail, every 4 block widths, over color2
+static void effect_chase(rgb_t *px, uint16_t n, int64_t now_us, uint32_t dt_us, const led_effect_params_t &p,
+                         EffectContext &ctx)
+{
+    int32_t width = (1 + p.size / 16) * 256;
+    int32_t period = 4 * width;
+    int32_t tail = (p.intensity * width * 3) >> 8;   // Up to the gap between blocks
+    uint32_t tail_inv = tail > 0 ? (1u << 24) / (uint32_t)tail : 0;
+    int32_t pos = (int32_t)(((uint64_t)(now_us / 1000) * p.speed * 128 / 1000) % (uint32_t)period);
+    for (uint16_t i = 0; i < n; i++) {
+        uint32_t level;
+        if (pos < width) {
+            level = 256;
+        } else if (pos < width + tail) {
+            level = 256 - (((uint32_t)(pos - width) * tail_inv) >> 16);
+        } else {
+            level = 0;
+        }
+        px[i] = blend(p.color2, p.color1, level);
+        pos -= 256;
+        if (pos < 0) {
+            pos += period;
+        }
+    }
+}
+
+static void effect_twinkle(rgb_t *px, uint16_t n, int64_t now_us, uint32_t dt_us, const led_effect_params_t &p,
+                           EffectContext &ctx)
+{
+    uint32_t fade = (dt_us * (p.speed + 1u)) >> 17;
+    if (fade == 0) {
+        fade = 1;
+    }
+    // intensity / 4 twinkles per second over the strip, as a per-LED chance in 2^-32
+    uint64_t chance = (uint64_t)p.intensity * dt_us * 1074u / n;
+    uint32_t threshold = chance > UINT32_MAX ? UINT32_MAX : (uint32_t)chance;
+    uint8_t *level = ctx.cells;
+    uint32_t rng = ctx.rng;
+    for (uint16_t i = 0; i < n; i++) {
+        uint32_t l = level[i] > fade ? level[i] - fade : 0;
+        if (xorshift(rng) < threshold) {
+            l = 255;
+        }
+        level[i] = (uint8_t)l;
+        px[i] = blend(p.color2, p.color1, weight(l));
+    }
+    ctx.rng = rng;
+}
+
+// Heat diffusion after the classic Fire2012: cool, drift up, spark at the base
+static void fire_step(uint8_t *heat, uint16_t n, const led_effect_params_t &p, uint32_t &rng)
+{
+    uint32_t cool_max = ((p.size * 10u) / n) + 2;
+    for (uint16_t i = 0; i < n; i++) {
+        uint32_t cool = ((xorshift(rng) & 0xFFFF) * cool_max) >> 16;
+        heat[i] = heat[i] > cool ? (uint8_t)(heat[i] - cool) : 0;
+    }
+    for (uint16_t k = n - 1; k >= 2; k--) {
+        heat[k] = (uint8_t)(((heat[k - 1] + 2u * heat[k - 2]) * 85) >> 8);
+    }
+    uint32_t r = xorshift(rng);
+    if ((r & 0xFF) < p.intensity) {
+        uint16_t y = (uint16_t)(((r >> 8) & 7) % (n < 7 ? n : 7));
+        uint32_t h = heat[y] + 160 + ((r >> 16) & 0x5F);
+        heat[y] = (uint8_t)(h > 255 ? 255 : h);
+    }
+}
+
+static void effect_fire(rgb_t *px, uint16_t n, int64_t now_us, uint32_t dt_us, const led_effect_params_t &p,
+                        EffectContext &ctx)
+{
+    uint32_t step_us = FIRE_STEP_US * 128u / (p.speed + 1u);
+    ctx.carry_us += dt_us;
+    for (int s = 0; s < FIRE_MAX_STEPS && ctx.carry_us >= step_us; s++) {
+        fire_step(ctx.cells, n, p, ctx.rng);
+        ctx.carry_us -= step_us;
+    }
+    if (ctx.carry_us >= step_us) {
+        ctx.carry_us = 0;
+    }
+
+    const uint8_t *heat = ctx.cells;
+    for (uint16_t i = 0; i < n; i++) {
+        // Black to red to yellow to white over 0-191
+        uint32_t t = (heat[i] * 192u) >> 8;
+        uint8_t ramp = (uint8_t)((t & 63) << 2);
+        if (t >= 128) {
+            px[i] = rgb_t{255, 255, ramp};
+        } else if (t >= 64) {
+            px[i] = rgb_t{255, ramp, 0};
+        } else {
+            px[i] = rgb_t{ramp, 0, 0};
+        }
+    }
+}
+
+// Two octaves of value noise, the finer one drifting faster
+static void effect_noise(rgb_t *px, uint16_t n, int64_t now_us, uint32_t dt_us, const led_effect_params_t &p,
+                         EffectContext &ctx)
+{
+    uint32_t step = 8 + p.size;
+    uint32_t drift = phase(now_us, p.speed * 32u);
+    NoiseOctave coarse{drift, step, 0x1234u};
+    NoiseOctave fine{drift * 3, step * 2, 0xBEEFu};
+    int32_t contrast = p.intensity + 64;   // 128 is unity
+    for (uint16_t i = 0; i < n; i++) {
+        int32_t v = (int32_t)((coarse.next() * 171 + fine.next() * 85) >> 8);
+        v = 128 + (((v - 128) * contrast) >> 7);
+        v = v < 0 ? 0 : (v > 255 ? 255 : v);
+        px[i] = blend(p.color1, p.color2, weight((uint32_t)v));
+    }
+}
+
+static void effect_breathing(rgb_t *px, uint16_t n, int64_t now_us, uint32_t dt_us, const led_effect_params_t &p,
+                             EffectContext &ctx)
+{
+    uint32_t ph = phase(now_us, p.speed * 65536u / 60) & 0xFFFF;
+    uint32_t tri = ph < 0x8000 ? ph >> 7 : (0xFFFF - ph) >> 7;
+    uint32_t level = 256 - ((weight(p.intensity) * (256 - weight(smoothstep8(tri)))) >> 8);
+    rgb_t c = scale(p.color1, level);
+    for (uint16_t i = 0; i < n; i++) {
+        px[i] = c;
+    }
+}
+
+struct EffectInfo {
+    const char *name;
+    EffectFn fn;
+    bool uses_cells;
+    led_effect_params_t defaults;
+};
+
+static const EffectInfo kEffects[EFFECT_COUNT] = {
+    {"gradient", effect_gradient, false, {64, 0, 0, {255, 0, 80}, {0, 80, 255}}},
+    {"rainbow", effect_rainbow, false, {64, 0, 255, {0, 0, 0}, {0, 0, 0}}},
+    {"chase", effect_chase, false, {60, 48, 128, {255, 120, 0}, {0, 0, 16}}},
+    {"twinkle", effect_twinkle, true, {128, 0, 128, {255, 220, 160}, {0, 0, 8}}},
+    {"fire", effect_fire, true, {128, 55, 120, {0, 0, 0}, {0, 0, 0}}},
+    {"noise", effect_noise, false, {64, 32, 128, {0, 20, 80}, {0, 200, 160}}},
+    {"breathing", effect_breathing, false, {12, 0, 224, {255, 140, 60}, {0, 0, 0}}},
+};
+
+// Both written under the strip's state lock, which the render task holds while generating
+static led_effect_params_t effect_params[EFFECT_COUNT];
+static int active_effect = EFFECT_RAINBOW;
+
+static EffectContext live_ctx = {-1, NULL, 0, 0x9E3779B9u, 0, 0};
+static RollingStats<EFFECT_COST_WINDOW> effect_cost[EFFECT_COUNT];   // ns per 100 LEDs, render task
+
+// Fresh state for a new effect or strip length; false if out of memory
+static bool prepare_context(EffectContext &ctx, int effect, uint16_t count)
+{
+    if (ctx.cell_count != count) {
+        free(ctx.cells);
+        ctx.cells = (uint8_t *)malloc(count);
+        ctx.cell_count = ctx.cells ? count : 0;
+        ctx.effect = -1;
+    }
+    if (ctx.effect != effect) {
+        if (ctx.cells) {
+            memset(ctx.cells, 0, ctx.cell_count);
+        }
+        ctx.effect = effect;
+        ctx.last_us = 0;
+        ctx.carry_us = 0;
+    }
+    return ctx.cells != NULL;
+}
+
+static void run_effect(int effect, rgb_t *frame, uint16_t count, int64_t now_us, EffectContext &ctx)
+{
+    uint32_t dt_us = 0;
+    if (ctx.last_us != 0) {
+        int64_t dt = now_us - ctx.last_us;
+        dt_us = (uint32_t)(dt < 0 ? 0 : (dt > EFFECT_MAX_STEP_US ? EFFECT_MAX_STEP_US : dt));
+    }
+    ctx.last_us = now_us;
+    kEffects[effect].fn(frame, count, now_us, dt_us, effect_params[effect], ctx);
+}
+
+// Render cost in ns per 100 LEDs. Timed in CPU cycles: a 150-LED frame
+// takes ~15 us, so esp_timer's 1 us resolution would be ~7% of it. The
+// counter is per core; the render task is pinned, and the benchmark holds
+// the scheduler off for each frame, so a frame never changes core.
+static uint32_t cost_per_100(uint64_t cycles, uint64_t leds)
+{
+    return (uint32_t)(cycles * 100000u / (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * leds));
+}
+
+static bool effect_generator(int64_t now_us, rgb_t *frame, uint16_t count, void *arg)
+{
+    int effect = active_effect;
+    if (count == 0 || (!prepare_context(live_ctx, effect, count) && kEffects[effect].uses_cells)) {
+        return false;
+    }
+    uint32_t start = esp_cpu_get_cycle_count();
+    run_effect(effect, frame, count, now_us, live_ctx);
+    effect_cost[effect].record(cost_per_100(esp_cpu_get_cycle_count() - start, count));
+    return true;
+}
+
+esp_err_t led_effects_init(void)
+{
+    for (int i = 0; i < EFFECT_COUNT; i++) {
+        effect_params[i] = kEffects[i].defaults;
+    }
+    return led_strip_set_generator(MODE_EFFECT, effect_generator, NULL, true);
+}
+
+const char *led_effect_name(int effect)
+{
+    if (effect < 0 || effect >= EFFECT_COUNT) {
+        return NULL;
+    }
+    return kEffects[effect].name;
+}
+
+int led_effect_find(const char *name)
+{
+    for (int i = 0; i < EFFECT_COUNT; i++) {
+        if (strcmp(kEffects[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool led_effect_select(int effect)
+{
+    if (effect < 0 || effect >= EFFECT_COUNT) {
+        return false;
+    }
+    led_strip_begin();
+    active_effect = effect;
+    led_strip_commit();
+    ESP_LOGI(TAG, "Effect: %s", kEffects[effect].name);
+    return true;
+}
+
+int led_effect_get_active(void)
+{
+    return active_effect;
+}
+
+bool led_effect_set_params(int effect, const led_effect_params_t *params)
+{
+    if (effect < 0 || effect >= EFFECT_COUNT) {
+        return false;
+    }
+    led_strip_begin();
+    effect_params[effect] = *params;
+    led_strip_commit();
+    return true;
+}
+
+bool led_effect_get_params(int effect, led_effect_params_t *params)
+{
+    if (effect < 0 || effect >= EFFECT_COUNT) {
+        return false;
+    }
+    led_strip_begin();
+    *params = effect_params[effect];
+    led_strip_commit();
+    return true;
+}
+
+static void to_cost(const RollingStats<EFFECT_COST_WINDOW> &stats, led_effect_cost_t *out)
+{
+    RollingStats<EFFECT_COST_WINDOW>::Summary summary;
+    uint32_t scratch[EFFECT_COST_WINDOW];
+    stats.summarize(&summary, scratch);
+    out->frames = summary.count;
+    out->ns_per_100_avg = summary.avg;
+    out->ns_per_100_p99 = summary.p99;
+    out->ns_per_100_max = summary.max;
+}
+
+bool led_effect_get_cost(int effect, led_effect_cost_t *out)
+{
+    if (effect < 0 || effect >= EFFECT_COUNT) {
+        return false;
+    }
+    to_cost(effect_cost[effect], out);
+    return true;
+}
+
+esp_err_t led_effects_benchmark(uint16_t led_count, int frames, led_effect_cost_t *out)
+{
+    if (led_count == 0 || frames <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    rgb_t *frame = (rgb_t *)calloc(led_count, sizeof(rgb_t));
+    EffectContext ctx = {-1, NULL, 0, 0x12345678u, 0, 0};
+    if (!frame || !prepare_context(ctx, 0, led_count)) {
+        free(frame);
+        free(ctx.cells);
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (int e = 0; e < EFFECT_COUNT; e++) {
+        // A private copy, so the live strip is not held up while this runs
+        led_effect_params_t params;
+        led_effect_get_params(e, &params);
+        prepare_context(ctx, e, led_count);
+        RollingStats<EFFECT_COST_WINDOW> stats;
+        int64_t now_us = 1000000;
+        uint64_t total_cycles = 0;
+        for (int f = 0; f < frames; f++, now_us += 10000) {
+            vTaskSuspendAll();
+            uint32_t start = esp_cpu_get_cycle_count();
+            kEffects[e].fn(frame, led_count, now_us, f == 0 ? 0 : 10000, params, ctx);
+            uint32_t cycles = esp_cpu_get_cycle_count() - start;
+            xTaskResumeAll();
+            total_cycles += cycles;
+            stats.record(cost_per_100(cycles, led_count));
+        }
+        to_cost(stats, &out[e]);
+        // The whole run, not just the last window
+        out[e].frames = (uint32_t)frames;
+        out[e].ns_per_100_avg = cost_per_100(total_cycles, (uint64_t)frames * led_count);
+    }
+    free(frame);
+    free(ctx.cells);
+    return ESP_OK;
+}
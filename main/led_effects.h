@@ -0,0 +1,90 @@
+#pragma once
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "freq_color_mapper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Built-in procedural effects, shown in MODE_EFFECT
+ *
+ * Every effect takes the same parameters; what they mean per effect:
+ *
+ * | effect    | speed               | size                 | intensity          | color1 / color2        |
+ * |-----------|---------------------|----------------------|--------------------|------------------------|
+ * | gradient  | scroll rate         | repeats on the strip | -                  | the two ends           |
+ * | rainbow   | cycle rate          | rainbows on the strip| saturation         | -                      |
+ * | chase     | LEDs per 2 seconds  | block width          | tail length        | block / background     |
+ * | twinkle   | fade rate           | -                    | twinkles per second| twinkle / background   |
+ * | fire      | simulation rate     | cooling              | sparking           | -                      |
+ * | noise     | drift rate          | feature density      | contrast           | low / high             |
+ * | breathing | breaths per minute  | -                    | depth              | colour                 |
+ */
+typedef enum {
+    EFFECT_GRADIENT,
+    EFFECT_RAINBOW,
+    EFFECT_CHASE,
+    EFFECT_TWINKLE,
+    EFFECT_FIRE,
+    EFFECT_NOISE,
+    EFFECT_BREATHING,
+    EFFECT_COUNT
+} led_effect_t;
+
+typedef struct {
+    uint8_t speed;       // 0-255
+    uint8_t size;        // 0-255
+    uint8_t intensity;   // 0-255
+    rgb_t color1;
+    rgb_t color2;
+} led_effect_params_t;
+
+typedef struct {
+    uint32_t frames;          // Frames in the window (live) or run (benchmark)
+    uint32_t ns_per_100_avg;  // Render cost per 100 LEDs, in nanoseconds
+    uint32_t ns_per_100_p99;
+    uint32_t ns_per_100_max;
+} led_effect_cost_t;
+
+/**
+ * @brief Install the effect generator for MODE_EFFECT
+ *
+ * Effects are evaluated in fixed point, a whole frame per call in one loop
+ * over the framebuffer. Call after led_strip_init().
+ */
+esp_err_t led_effects_init(void);
+
+const char *led_effect_name(int effect);
+int led_effect_find(const char *name);   // -1 if there is none by that name
+
+bool led_effect_select(int effect);
+int led_effect_get_active(void);
+
+// Each effect keeps its own parameters, starting from sensible defaults
+bool led_effect_set_params(int effect, const led_effect_params_t *params);
+bool led_effect_get_params(int effect, led_effect_params_t *params);
+
+// Cost of an effect over its last 64 rendered frames on the strip
+bool led_effect_get_cost(int effect, led_effect_cost_t *out);
+
+/**
+ * @brief Time every effect on a scratch buffer of led_count LEDs
+ *
+ * Runs off the render task with each effect's current parameters and
+ * simulated 10 ms frame steps. Each frame is timed with the scheduler
+ * suspended, which holds up other tasks on this core for that long. Dividing 10,000 µs by ns_per_100_avg / 1000
+ * and multiplying by 100 gives the longest strip an effect alone can fill
+ * at 100 fps.
+ *
+ * @param out EFFECT_COUNT results
+ * @return esp_err_t ESP_OK, or ESP_ERR_NO_MEM
+ */
+esp_err_t led_effects_benchmark(uint16_t led_count, int frames, led_effect_cost_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,17 +1,33 @@
 #include "led_strip_control.h"
+#include "freq_color_mapper.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "driver/rmt_tx.h"
-#include "led_strip.h"
-#include <cmath>
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "rolling_stats.h"
+#include "ws2812_rmt.h"
+#include "sdkconfig.h"
+#include <array>
+#include <atomic>
+#include <stdlib.h>
 #include <string.h> // For strcmp
+#include <strings.h>
 
 static const char *TAG = "led_strip_control";
 
+// One physical strip: a range of the framebuffer on its own RMT channel
+struct Output {
+    ws2812_rmt_handle_t tx;
+    uint16_t first;             // Its first LED in the framebuffer
+    led_output_config_t config;
+    uint8_t pos[3];             // Wire offsets of the red, green and blue bytes
+};
+
 // LED strip control variables
-static led_strip_handle_t led_strip;
-static uint16_t strip_led_count = 0;
+static Output outputs[LED_MAX_OUTPUTS];
+static int output_count = 0;
+static uint16_t strip_led_count = 0;   // Across all outputs
 static bool power_on = true;
 static uint8_t current_brightness = 255;
 static uint16_t current_hue = 0;
@@ -25,299 +41,833 @@ static uint8_t environmental_r = 0;
 static uint8_t environmental_g = 0;
 static uint8_t environmental_b = 150; // Default to blueish
 
-// Convert color temperature to RGB
-static void temp2rgb(uint32_t temp_k, uint8_t *r, uint8_t *g, uint8_t *b)
+/*
+ * Output stage. Every mode writes full-brightness colours into the
+ * framebuffer; output_frame() then maps each channel through a table that
+ * folds in the global brightness, the gamma curve and the install's white
+ * balance, and sends the frame. The tables are rebuilt (in integer maths)
+ * only when brightness or white balance change.
+ *
+ * Everything after the framebuffer is 16-bit: the tables take and return
+ * Q8.8, interpolating between their 256 entries, and the final conversion
+ * to 8 bits carries each channel's rounding error into the next frame
+ * (temporal dithering). At low brightness that turns the few output
+ * levels left after gamma into smooth averages, provided the strip is
+ * refreshed at a steady rate, which render_task does while any channel
+ * sits between two levels. With a dither hold set, a frame that has been
+ * settled and unchanged for that long is rounded instead, so a static
+ * colour lets the clock stop at the cost of a sub-step change at low levels.
+ */
+static rgb_t *framebuffer = NULL;
+static uint8_t white_balance[3] = {CONFIG_LED_WHITE_BALANCE_R, CONFIG_LED_WHITE_BALANCE_G,
+                                   CONFIG_LED_WHITE_BALANCE_B};
+static uint16_t output_lut[3][257];    // Q8.8; the extra entry is for interpolation at 255
+static volatile bool output_lut_dirty = true;
+static uint8_t *dither_error = NULL;   // 3 channels per LED, the fraction left over last frame
+#if CONFIG_LED_DITHER
+static volatile bool dither_enabled = true;
+#else
+static volatile bool dither_enabled = false;   // A disabled bool option leaves CONFIG_LED_DITHER undefined
+#endif
+static volatile bool dither_active = false;   // Last frame had channels between two levels
+static volatile uint32_t dither_hold_ms = CONFIG_LED_DITHER_HOLD_MS;   // 0 dithers static frames indefinitely
+static uint32_t dither_hold_frames = 0;       // Settled, unchanged frames dithered so far
+static RollingStats<64> output_time_us;       // Written under output_lock
+static std::atomic<uint32_t> output_frames{0};
+
+// A frame is on the wire for 30 us per LED; waiting longer than this for
+// the previous one means the transmitter is stuck
+#define OUTPUT_TX_TIMEOUT_MS 100
+
+/*
+ * Temporal smoothing, between the framebuffer and the output tables: each
+ * channel of each LED follows its framebuffer value through a first-order
+ * filter in Q8.8, with separate time constants for rising (attack) and
+ * falling (release) values. The per-frame coefficient dt / (tau + dt) is
+ * worked out once per frame, so the filter is right at any frame rate.
+ * The render task keeps ticking until every channel has reached its target.
+ */
+#define SMOOTH_MAX_STEP_US 20000       // Longest step one frame may take, so a change after idle still fades
+static uint16_t *smooth_state = NULL;  // 3 channels per LED, Q8.8
+static volatile uint32_t attack_ms = CONFIG_LED_SMOOTH_ATTACK_MS;
+static volatile uint32_t release_ms = CONFIG_LED_SMOOTH_RELEASE_MS;
+static volatile bool smooth_settled = true;
+static int64_t last_output_us = 0;
+static SemaphoreHandle_t output_lock = NULL;
+
+/*
+ * Render scheduler. render_task is the only writer of the framebuffer and
+ * the only caller of output_frame(). While there is work it is woken by a
+ * periodic esp_timer at CONFIG_LED_FRAME_RATE_HZ (the FreeRTOS tick is too
+ * coarse for these rates) and, on each tick, asks the current mode's frame
+ * generator for the frame at that time. The frame goes out if it changed,
+ * if the output tables changed, or while a fade or dither is running. With
+ * nothing to do the timer is stopped and the task sleeps until a state
+ * commit or led_strip_request_frame() wakes it.
+ *
+ * A tick that fires while the previous one is still being rendered is
+ * dropped and counted.
+ */
+#define RENDER_TASK_STACK 4096
+#define RENDER_TASK_PRIORITY 5
+// Pinned, so generators can time themselves with the per-core cycle counter;
+// on the audio core, away from Wi-Fi and the Matter stack
+#if CONFIG_FREERTOS_UNICORE || portNUM_PROCESSORS == 1
+#define RENDER_TASK_CORE 0
+#else
+#define RENDER_TASK_CORE 1
+#endif
+#define RENDER_WAKE_TICK (1u << 0)     // From the frame timer
+#define RENDER_WAKE_KICK (1u << 1)     // New state or input
+struct FrameGenerator {
+    led_frame_generator_t fn;
+    void *ctx;
+    bool animated;
+};
+static FrameGenerator generators[MODE_COUNT];
+static TaskHandle_t render_task_handle = NULL;
+static esp_timer_handle_t frame_timer = NULL;
+static std::atomic<uint32_t> frame_ticks{0};      // Timer callback
+static std::atomic<uint32_t> dropped_frames{0};   // Render task
+static std::atomic<bool> input_pending{false};    // Set by led_strip_request_frame()
+static std::atomic<bool> resend_pending{false};   // Send the current frame again, e.g. to start dithering it
+static RollingStats<64> render_time_us;           // Render task: generator plus output stage
+
+/*
+ * State transactions. Setters change the light state between
+ * led_strip_begin() and led_strip_commit() (each setter opens its own if
+ * none is open), and only mark it dirty when a value actually changes.
+ * The last commit of a dirty transaction asks render_task to render the
+ * state on its next tick, so a burst of changes (a scene recall, a web
+ * request setting hue and saturation) becomes one frame, and a frame
+ * identical to the last one is not sent at all.
+ */
+static SemaphoreHandle_t state_lock = NULL;   // Recursive; held for a whole transaction
+static int transaction_depth = 0;
+static bool state_dirty = false;
+static std::atomic<bool> render_requested{false};
+
+namespace {
+
+constexpr double ln_cx(double x)
 {
-    // Override for common Matter values (direct mapping approach)
-    // Matter uses mireds, where 153 = 6500K (cool) and 370 = 2700K (warm)
-    // Instead of complex math, we'll use a direct mapping for key values
-    
-    uint8_t brightness_factor = current_brightness;
-    float brightness_scale = brightness_factor / 255.0f;
-    
-    // Specific preset colors for common temperatures
-    if (temp_k >= 6500) { // 153 mireds or less - Cool white
-        *r = 255 * brightness_scale;
-        *g = 255 * brightness_scale;
-        *b = 255 * brightness_scale;
-        ESP_LOGI(TAG, "Using cool white preset (6500K+)");
-    } 
-    else if (temp_k >= 5000) { // ~200 mireds - Daylight
-        *r = 255 * brightness_scale;
-        *g = 240 * brightness_scale;
-        *b = 230 * brightness_scale;
-        ESP_LOGI(TAG, "Using daylight preset (5000-6500K)");
-    }
-    else if (temp_k >= 4000) { // ~250 mireds - Neutral
-        *r = 255 * brightness_scale;
-        *g = 225 * brightness_scale;
-        *b = 200 * brightness_scale;
-        ESP_LOGI(TAG, "Using neutral preset (4000-5000K)");
-    }
-    else if (temp_k >= 3000) { // ~333 mireds - Warm white
-        *r = 255 * brightness_scale;
-        *g = 180 * brightness_scale;
-        *b = 130 * brightness_scale;
-        ESP_LOGI(TAG, "Using warm white preset (3000-4000K)");
-    }
-    else if (temp_k >= 2700) { // ~370 mireds - Incandescent
-        *r = 255 * brightness_scale;
-        *g = 160 * brightness_scale;
-        *b = 80 * brightness_scale; 
-        ESP_LOGI(TAG, "Using incandescent preset (2700-3000K)");
-    }
-    else { // < 2700K (>370 mireds) - Very warm
-        *r = 255 * brightness_scale;
-        *g = 140 * brightness_scale;
-        *b = 40 * brightness_scale;
-        ESP_LOGI(TAG, "Using very warm preset (<2700K)");
+    // Reduce to [0.5, 1), then ln(x) = 2 atanh((x - 1) / (x + 1))
+    int k = 0;
+    while (x < 0.5) { x *= 2.0; k--; }
+    while (x >= 1.0) { x *= 0.5; k++; }
+    double z = (x - 1.0) / (x + 1.0);
+    double term = z;
+    double sum = 0.0;
+    for (int n = 0; n < 20; n++) {
+        sum += term / (2 * n + 1);
+        term *= z * z;
     }
-    
-    ESP_LOGI(TAG, "Temperature %luK -> RGB: (%u,%u,%u) with brightness %u", 
-             (unsigned long)temp_k, *r, *g, *b, brightness_factor);
+    return 2.0 * sum + k * 0.69314718055994531;
+}
+
+constexpr double exp_cx(double y)
+{
+    // Taylor series on y / 1024, squared back up
+    double x = y / 1024.0;
+    double term = 1.0;
+    double sum = 1.0;
+    for (int n = 1; n < 12; n++) {
+        term *= x / n;
+        sum += term;
+    }
+    for (int i = 0; i < 10; i++) {
+        sum *= sum;
+    }
+    return sum;
+}
+
+// (i / 255) ^ gamma in Q16
+constexpr std::array<uint16_t, 256> make_gamma_table(double gamma)
+{
+    std::array<uint16_t, 256> t{};
+    for (int i = 1; i < 256; i++) {
+        double v = exp_cx(gamma * ln_cx(i / 255.0)) * 65535.0 + 0.5;
+        t[i] = (uint16_t)(v > 65535.0 ? 65535.0 : v);
+    }
+    return t;
+}
+
+constexpr std::array<uint16_t, 256> kGamma = make_gamma_table(CONFIG_LED_GAMMA_X10 / 10.0);
+static_assert(kGamma[255] == 65535 && kGamma[0] == 0, "Gamma table must span the full range");
+
+#define BLACKBODY_MIN_K 1000
+#define BLACKBODY_MAX_K 10000
+#define BLACKBODY_STEP_K 100
+
+constexpr uint8_t clamp_channel(double v)
+{
+    return (uint8_t)(v <= 0.0 ? 0 : v >= 255.0 ? 255 : v + 0.5);
+}
+
+// Blackbody colour as sRGB at full brightness, by Tanner Helland's fit to
+// the CIE 1964 10-degree colour matching functions; t is kelvin / 100
+constexpr rgb_t blackbody_cx(double t)
+{
+    double r = (t <= 66.0) ? 255.0 : 329.698727446 * exp_cx(-0.1332047592 * ln_cx(t - 60.0));
+    double g = (t <= 66.0) ? 99.4708025861 * ln_cx(t) - 161.1195681661
+                           : 288.1221695283 * exp_cx(-0.0755148492 * ln_cx(t - 60.0));
+    double b = (t >= 66.0) ? 255.0 : (t <= 19.0) ? 0.0 : 138.5177312231 * ln_cx(t - 10.0) - 305.0447927307;
+    return rgb_t{clamp_channel(r), clamp_channel(g), clamp_channel(b)};
+}
+
+constexpr size_t kBlackbodySteps = (BLACKBODY_MAX_K - BLACKBODY_MIN_K) / BLACKBODY_STEP_K + 1;
+
+constexpr std::array<rgb_t, kBlackbodySteps> make_blackbody_table()
+{
+    std::array<rgb_t, kBlackbodySteps> t{};
+    for (size_t i = 0; i < kBlackbodySteps; i++) {
+        t[i] = blackbody_cx((BLACKBODY_MIN_K + i * BLACKBODY_STEP_K) / 100.0);
+    }
+    return t;
+}
+
+constexpr std::array<rgb_t, kBlackbodySteps> kBlackbody = make_blackbody_table();
+
+} // namespace
+
+static void rebuild_output_lut()
+{
+    output_lut_dirty = false;
+    uint32_t brightness = current_brightness;
+    for (int c = 0; c < 3; c++) {
+        uint32_t balance = white_balance[c];
+        for (int v = 0; v < 256; v++) {
+            // Brightness-scaled input as a gamma table position with an 8-bit fraction
+            uint32_t scaled = v * brightness;
+            uint32_t index = scaled / 255;
+            uint32_t frac = (scaled % 255) * 256 / 255;
+            uint32_t next = index < 255 ? index + 1 : 255;
+            uint32_t g = kGamma[index] + (((kGamma[next] - kGamma[index]) * frac) >> 8);
+            output_lut[c][v] = (uint16_t)(((uint64_t)g * balance * 256 + 32767) / 65535);
+        }
+        output_lut[c][256] = output_lut[c][255];
+    }
+}
+
+// Q8.8 in, Q8.8 out
+static inline uint32_t lut_lookup(const uint16_t *lut, uint32_t v)
+{
+    uint32_t i = v >> 8;
+    return lut[i] + ((((int32_t)lut[i + 1] - (int32_t)lut[i]) * (int32_t)(v & 0xFF)) >> 8);
+}
+
+// Q8.8 to 8 bits, either dithered (the remainder carries into the next
+// frame) or rounded
+static inline uint8_t quantize(uint32_t v, uint8_t *error, bool dither, bool *fraction)
+{
+    if (!dither) {
+        return (uint8_t)((v + 128) >> 8);
+    }
+    *fraction = *fraction || (v & 0xFF) != 0;
+    v += *error;
+    *error = (uint8_t)(v & 0xFF);
+    return (uint8_t)(v >> 8);
+}
+
+// Q16 coefficient of a first-order filter with time constant tau for a dt step
+static uint32_t smooth_coefficient(uint32_t tau_ms, uint32_t dt_us)
+{
+    uint64_t tau_us = (uint64_t)tau_ms * 1000;
+    if (tau_us == 0) {
+        return 65536;
+    }
+    return (uint32_t)(((uint64_t)dt_us << 16) / (tau_us + dt_us));
+}
+
+// Move one channel towards its target; returns the new state
+static inline uint16_t smooth_step(uint16_t state, uint16_t target, uint32_t rise, uint32_t fall)
+{
+    int32_t diff = (int32_t)target - (int32_t)state;
+    if (diff <= 128 && diff >= -128) {
+        return target;  // Within half an output step
+    }
+    int32_t step = (int32_t)(((int64_t)diff * (diff > 0 ? rise : fall)) >> 16);
+    if (step == 0) {
+        step = diff > 0 ? 1 : -1;
+    }
+    return (uint16_t)(state + step);
+}
+
+// A fade or the dithering needs frames even when the framebuffer is static
+static bool refresh_needed()
+{
+    return dither_active || !smooth_settled;
+}
+
+// Send the framebuffer through the smoothing and output stages; fresh is
+// set when the framebuffer, the tables or the settings behind them changed
+static esp_err_t output_frame(bool fresh)
+{
+    xSemaphoreTake(output_lock, portMAX_DELAY);
+    int64_t now = esp_timer_get_time();
+    if (output_lut_dirty) {
+        rebuild_output_lut();
+    }
+
+    uint32_t dt_us = (uint32_t)((last_output_us == 0 || now - last_output_us > SMOOTH_MAX_STEP_US)
+                                    ? SMOOTH_MAX_STEP_US : now - last_output_us);
+    last_output_us = now;
+    uint32_t rise = smooth_coefficient(attack_ms, dt_us);
+    uint32_t fall = smooth_coefficient(release_ms, dt_us);
+
+    const uint16_t *lut_r = output_lut[0];
+    const uint16_t *lut_g = output_lut[1];
+    const uint16_t *lut_b = output_lut[2];
+    if (fresh || !smooth_settled) {
+        dither_hold_frames = 0;
+    }
+    uint32_t hold_ms = dither_hold_ms;
+    uint32_t hold_frames = (hold_ms * CONFIG_LED_FRAME_RATE_HZ + 999) / 1000;
+    bool dither = dither_enabled && (hold_ms == 0 || dither_hold_frames < hold_frames);
+    dither_hold_frames += (dither && hold_ms != 0) ? 1 : 0;
+    bool settled = true;
+    bool fraction = false;
+    esp_err_t err = ESP_OK;
+    uint16_t *state = smooth_state;
+    uint8_t *error = dither_error;
+    const rgb_t *pixel = framebuffer;
+    for (int o = 0; o < output_count; o++) {
+        const Output &output = outputs[o];
+        const uint8_t pr = output.pos[0], pg = output.pos[1], pb = output.pos[2];
+        uint8_t *out = ws2812_rmt_back_buffer(output.tx);
+        for (int i = 0; i < output.config.led_count; i++, pixel++, state += 3, error += 3, out += 3) {
+            rgb_t p = *pixel;
+            uint16_t r = smooth_step(state[0], (uint16_t)(p.r << 8), rise, fall);
+            uint16_t g = smooth_step(state[1], (uint16_t)(p.g << 8), rise, fall);
+            uint16_t b = smooth_step(state[2], (uint16_t)(p.b << 8), rise, fall);
+            settled = settled && r == (p.r << 8) && g == (p.g << 8) && b == (p.b << 8);
+            state[0] = r;
+            state[1] = g;
+            state[2] = b;
+            out[pr] = quantize(lut_lookup(lut_r, r), &error[0], dither, &fraction);
+            out[pg] = quantize(lut_lookup(lut_g, g), &error[1], dither, &fraction);
+            out[pb] = quantize(lut_lookup(lut_b, b), &error[2], dither, &fraction);
+        }
+    }
+    // Every segment is ready, so the strips start within a few microseconds
+    // of each other. Each submit returns once its segment is queued; the
+    // previous frame has normally finished by now.
+    for (int o = 0; o < output_count; o++) {
+        esp_err_t submit = ws2812_rmt_submit(outputs[o].tx, OUTPUT_TX_TIMEOUT_MS);
+        if (submit != ESP_OK) {
+            err = submit;
+        }
+    }
+    output_time_us.record((uint32_t)(esp_timer_get_time() - now));
+    output_frames.store(output_frames.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    smooth_settled = settled;
+    dither_active = fraction;
+    xSemaphoreGive(output_lock);
+    return err;
 }
 
-// Convert mired to Kelvin
+// Returns whether any pixel changed
+static bool fill_frame(rgb_t *frame, uint16_t count, rgb_t c)
+{
+    bool changed = false;
+    for (int i = 0; i < count; i++) {
+        rgb_t &p = frame[i];
+        changed = changed || p.r != c.r || p.g != c.g || p.b != c.b;
+        p = c;
+    }
+    return changed;
+}
+
+// Hue 0-359 and saturation 0-255 at full value
+static rgb_t hsv2rgb(uint16_t hue, uint8_t saturation)
+{
+    hue %= 360;
+    uint32_t region = hue / 60;
+    uint32_t rem = (hue % 60) * 255 / 60;
+    uint8_t p = (uint8_t)(255 - saturation);
+    uint8_t q = (uint8_t)(255 - (saturation * rem + 127) / 255);
+    uint8_t t = (uint8_t)(255 - (saturation * (255 - rem) + 127) / 255);
+    switch (region) {
+        case 0: return rgb_t{255, t, p};
+        case 1: return rgb_t{q, 255, p};
+        case 2: return rgb_t{p, 255, t};
+        case 3: return rgb_t{p, q, 255};
+        case 4: return rgb_t{t, p, 255};
+        default: return rgb_t{255, p, q};
+    }
+}
+
+// Convert color temperature to RGB, at full brightness, by interpolating
+// the blackbody table
+static rgb_t temp2rgb(uint32_t temp_k)
+{
+    if (temp_k <= BLACKBODY_MIN_K) {
+        return kBlackbody[0];
+    }
+    uint32_t offset = temp_k - BLACKBODY_MIN_K;
+    uint32_t i = offset / BLACKBODY_STEP_K;
+    if (i >= kBlackbody.size() - 1) {
+        return kBlackbody[kBlackbody.size() - 1];
+    }
+    uint32_t frac = (offset % BLACKBODY_STEP_K) * 256 / BLACKBODY_STEP_K;
+    const rgb_t &a = kBlackbody[i];
+    const rgb_t &b = kBlackbody[i + 1];
+    return rgb_t{(uint8_t)(a.r + (((b.r - a.r) * (int32_t)frac) >> 8)),
+                 (uint8_t)(a.g + (((b.g - a.g) * (int32_t)frac) >> 8)),
+                 (uint8_t)(a.b + (((b.b - a.b) * (int32_t)frac) >> 8))};
+}
+
+// Convert mired to Kelvin, within the blackbody table's range
 static uint32_t mired_to_kelvin(uint32_t mired)
 {
     // Mired is 1,000,000/kelvin
-    // To convert: kelvin = 1,000,000/mired
-    
-    // Handle special case for very large values to avoid division by zero
     if (mired < 1) {
         return 6500; // Default to daylight
     }
-    
-    // Do the conversion
     uint32_t kelvin = 1000000 / mired;
-    
-    // Constrain to reasonable values
-    if (kelvin < 1000) kelvin = 1000;
-    if (kelvin > 10000) kelvin = 10000;
-    
-    ESP_LOGI(TAG, "Converting %lu mireds to %lu K", (unsigned long)mired, (unsigned long)kelvin);
-    
+    if (kelvin < BLACKBODY_MIN_K) kelvin = BLACKBODY_MIN_K;
+    if (kelvin > BLACKBODY_MAX_K) kelvin = BLACKBODY_MAX_K;
     return kelvin;
 }
 
-// Update the LED strip based on current settings
+// Solid colour from the manual settings; runs with state_lock held
+static bool manual_generator(int64_t now_us, rgb_t *frame, uint16_t count, void *ctx)
+{
+    rgb_t c = use_temperature_mode ? temp2rgb(current_temperature) : hsv2rgb(current_hue, current_saturation);
+    return fill_frame(frame, count, c);
+}
+
+static bool environmental_generator(int64_t now_us, rgb_t *frame, uint16_t count, void *ctx)
+{
+    return fill_frame(frame, count, rgb_t{environmental_r, environmental_g, environmental_b});
+}
+
+// One frame tick; returns whether the clock should keep running
+static bool render_tick(int64_t now_us)
+{
+    int64_t start = esp_timer_get_time();
+    bool state_changed = render_requested.exchange(false);
+    bool input = input_pending.exchange(false);
+    bool resend = resend_pending.exchange(false);
+
+    xSemaphoreTakeRecursive(state_lock, portMAX_DELAY);
+    const FrameGenerator &gen = generators[current_mode];
+    bool animated = power_on && gen.animated;
+    bool changed = false;
+    if (!power_on) {
+        // Off regardless of mode
+        changed = state_changed && fill_frame(framebuffer, strip_led_count, rgb_t{0, 0, 0});
+    } else if (gen.fn && (animated || state_changed || input)) {
+        changed = gen.fn(now_us, framebuffer, strip_led_count, gen.ctx);
+    }
+    xSemaphoreGiveRecursive(state_lock);
+
+    bool fresh = changed || resend || output_lut_dirty;
+    if (fresh || refresh_needed()) {
+        output_frame(fresh);
+        render_time_us.record((uint32_t)(esp_timer_get_time() - start));
+    }
+    return animated || refresh_needed() || render_requested.load() || input_pending.load();
+}
+
+static void frame_timer_callback(void *arg)
+{
+    frame_ticks.fetch_add(1, std::memory_order_relaxed);
+    xTaskNotify(render_task_handle, RENDER_WAKE_TICK, eSetBits);
+}
+
+static void wake_render_task()
+{
+    if (render_task_handle) {
+        xTaskNotify(render_task_handle, RENDER_WAKE_KICK, eSetBits);
+    }
+}
+
+// Starts the frame clock when woken from idle (the first frame follows one
+// period later, which folds bursts of commits together), renders on each
+// tick, and stops the clock once a tick finds nothing left to do
+static void render_task(void *pvParameters)
+{
+    const uint64_t period_us = 1000000 / CONFIG_LED_FRAME_RATE_HZ;
+    bool running = false;
+    uint32_t handled = 0;
+    while (1) {
+        uint32_t wake = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &wake, portMAX_DELAY);
+        if (!running) {
+            handled = frame_ticks.load(std::memory_order_relaxed);
+            running = esp_timer_start_periodic(frame_timer, period_us) == ESP_OK;
+            continue;
+        }
+        if (!(wake & RENDER_WAKE_TICK)) {
+            continue;
+        }
+        uint32_t fired = frame_ticks.load(std::memory_order_relaxed);
+        if (fired - handled > 1) {
+            dropped_frames.store(dropped_frames.load(std::memory_order_relaxed) + (fired - handled - 1),
+                                 std::memory_order_relaxed);
+        }
+        handled = fired;
+
+        if (!render_tick(esp_timer_get_time())) {
+            esp_timer_stop(frame_timer);
+            running = false;
+        }
+    }
+}
+
+void led_strip_begin(void)
+{
+    xSemaphoreTakeRecursive(state_lock, portMAX_DELAY);
+    transaction_depth++;
+}
+
+esp_err_t led_strip_commit(void)
+{
+    bool render = --transaction_depth == 0 && state_dirty;
+    if (render) {
+        state_dirty = false;
+        render_requested = true;
+    }
+    xSemaphoreGiveRecursive(state_lock);
+    if (render) {
+        wake_render_task();
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_strip_set_generator(led_strip_mode_t mode, led_frame_generator_t generator, void *ctx,
+                                  bool animated)
+{
+    if (mode < MODE_MANUAL || mode >= MODE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Under state_lock, so the render task never sees half a slot
+    led_strip_begin();
+    generators[mode] = FrameGenerator{generator, ctx, animated};
+    state_dirty = state_dirty || mode == current_mode;
+    return led_strip_commit();
+}
+
+void led_strip_request_frame(void)
+{
+    input_pending.store(true);
+    wake_render_task();
+}
+
+// Request a render of the current state, e.g. after new environmental data
 esp_err_t update_led_strip()
 {
-    if (!led_strip) {
+    if (output_count == 0) {
         ESP_LOGE(TAG, "LED strip not initialized");
         return ESP_ERR_INVALID_STATE;
     }
+    led_strip_begin();
+    state_dirty = true;
+    return led_strip_commit();
+}
 
-    ESP_LOGI(TAG, "Updating LED strip - power:%d, mode:%d, brightness:%d",
-            power_on, current_mode, current_brightness);
+static const char *const kColorOrders[] = {"GRB", "RGB", "BRG", "RBG", "GBR", "BGR"};
 
-    if (!power_on) {
-        // Turn off all LEDs regardless of mode
-        ESP_LOGI(TAG, "Turning off all LEDs");
-        for (int i = 0; i < strip_led_count; i++) {
-            led_strip_set_pixel(led_strip, i, 0, 0, 0);
+bool led_color_order_parse(const char *name, led_color_order_t *order)
+{
+    for (int i = 0; name && i < (int)(sizeof(kColorOrders) / sizeof(kColorOrders[0])); i++) {
+        if (strcasecmp(name, kColorOrders[i]) == 0) {
+            *order = (led_color_order_t)i;
+            return true;
         }
-    } else {
-        // Handle different modes only if power is on
-        switch (current_mode) {
-            case MODE_MANUAL:
-                ESP_LOGI(TAG, "Updating in MANUAL mode");
-                if (use_temperature_mode) {
-                    uint8_t r, g, b;
-                    temp2rgb(current_temperature, &r, &g, &b);
-                    ESP_LOGI(TAG, "Setting all LEDs to temperature color: RGB(%d,%d,%d)", r, g, b);
-                    for (int i = 0; i < strip_led_count; i++) {
-                        led_strip_set_pixel(led_strip, i, r, g, b);
-                    }
-                } else {
-                    ESP_LOGI(TAG, "Setting all LEDs to HSV: (%d,%d,%d)",
-                            current_hue, current_saturation, current_brightness);
-                    for (int i = 0; i < strip_led_count; i++) {
-                        led_strip_set_pixel_hsv(led_strip, i, current_hue, current_saturation, current_brightness);
-                    }
-                }
-                break;
-
-            case MODE_ADAPTIVE:
-                ESP_LOGD(TAG, "Skipping update in ADAPTIVE mode (handled by FFT task)");
-                // Colors are set directly by the FFT algorithm via led_strip_set_pixel_color
-                // Refresh happens in led_strip_update() called by the task
-                break;
-
-            case MODE_ENVIRONMENTAL:
-            { // Add opening brace
-                ESP_LOGI(TAG, "Updating in ENVIRONMENTAL mode");
-                // Use the pre-calculated environmental colors, scaled by brightness
-                float brightness_scale = (float)current_brightness / 255.0f;
-                uint8_t r = (uint8_t)((float)environmental_r * brightness_scale);
-                uint8_t g = (uint8_t)((float)environmental_g * brightness_scale);
-                uint8_t b = (uint8_t)((float)environmental_b * brightness_scale);
-                ESP_LOGI(TAG, "Setting all LEDs to environmental color: RGB(%d,%d,%d)", r, g, b);
-                for (int i = 0; i < strip_led_count; i++) {
-                    led_strip_set_pixel(led_strip, i, r, g, b);
-                }
-            } // Add closing brace
-            break;
+    }
+    return false;
+}
+
+const char *led_color_order_name(led_color_order_t order)
+{
+    return (unsigned)order < sizeof(kColorOrders) / sizeof(kColorOrders[0]) ? kColorOrders[order] : "?";
+}
+
+static void delete_outputs()
+{
+    for (int o = 0; o < output_count; o++) {
+        ws2812_rmt_del(outputs[o].tx);
+        outputs[o].tx = NULL;
+    }
+    output_count = 0;
+}
+
+esp_err_t led_strip_init_outputs(const led_output_config_t *configs, int count)
+{
+    if (configs == NULL || count < 1 || count > LED_MAX_OUTPUTS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t total = 0;
+    for (int o = 0; o < count; o++) {
+        bool shared_gpio = false;
+        for (int other = 0; other < o; other++) {
+            shared_gpio = shared_gpio || configs[other].gpio_num == configs[o].gpio_num;
+        }
+        if (configs[o].led_count == 0 || led_color_order_name(configs[o].order)[0] == '?' || shared_gpio) {
+            ESP_LOGE(TAG, "Invalid configuration for output %d", o + 1);
+            return ESP_ERR_INVALID_ARG;
+        }
+        total += configs[o].led_count;
+    }
+    if (total > UINT16_MAX) {
+        ESP_LOGE(TAG, "%lu LEDs is more than the framebuffer can address", (unsigned long)total);
+        return ESP_ERR_INVALID_ARG;
+    }
+    ESP_LOGI(TAG, "Initializing %d LED output(s), %lu LEDs in total", count, (unsigned long)total);
 
-            default:
-                ESP_LOGW(TAG, "Unknown mode: %d", current_mode);
-                break;
+    bool first_init = output_lock == NULL;
+    if (first_init) {
+        output_lock = xSemaphoreCreateMutex();
+        state_lock = xSemaphoreCreateRecursiveMutex();
+        esp_timer_create_args_t timer_args = {};
+        timer_args.callback = frame_timer_callback;
+        timer_args.name = "led_frame";
+        if (output_lock == NULL || state_lock == NULL || esp_timer_create(&timer_args, &frame_timer) != ESP_OK ||
+            xTaskCreatePinnedToCore(render_task, "led_render", RENDER_TASK_STACK, NULL, RENDER_TASK_PRIORITY,
+                                    &render_task_handle, RENDER_TASK_CORE) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create the render task");
+            return ESP_ERR_NO_MEM;
         }
+        generators[MODE_MANUAL] = FrameGenerator{manual_generator, NULL, false};
+        generators[MODE_ENVIRONMENTAL] = FrameGenerator{environmental_generator, NULL, false};
     }
 
-    // Refresh the strip display unless in adaptive mode (refreshed by FFT task)
-    // Allow refresh even if power is off to ensure LEDs are cleared
-    if (current_mode != MODE_ADAPTIVE) {
-         ESP_LOGI(TAG, "Refreshing LED strip display for mode %d", current_mode);
-         return led_strip_refresh(led_strip);
-    } else {
-        // Adaptive mode refreshes in its own task via led_strip_update()
-        return ESP_OK;
+    rgb_t *pixels = (rgb_t *)calloc(total, sizeof(rgb_t));
+    uint16_t *state = (uint16_t *)calloc(total * 3, sizeof(uint16_t));
+    uint8_t *error = (uint8_t *)calloc(total * 3, sizeof(uint8_t));
+    if (pixels == NULL || state == NULL || error == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate the framebuffer");
+        free(pixels);
+        free(state);
+        free(error);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Keep the render task off the buffers and channels while they are replaced
+    xSemaphoreTakeRecursive(state_lock, portMAX_DELAY);
+    xSemaphoreTake(output_lock, portMAX_DELAY);
+    delete_outputs();
+    free(framebuffer);
+    free(smooth_state);
+    free(dither_error);
+    framebuffer = pixels;
+    smooth_state = state;
+    dither_error = error;
+    strip_led_count = (uint16_t)total;
+
+    esp_err_t ret = ESP_OK;
+    uint16_t first = 0;
+    for (int o = 0; o < count && ret == ESP_OK; o++) {
+        ws2812_rmt_config_t strip_config = {
+            .gpio_num = configs[o].gpio_num,
+            .led_count = configs[o].led_count,
+        };
+        Output &output = outputs[o];
+        ret = ws2812_rmt_new(&strip_config, &output.tx);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create output %d: %s", o + 1, esp_err_to_name(ret));
+            break;
+        }
+        output.first = first;
+        output.config = configs[o];
+        const char *order = kColorOrders[configs[o].order];
+        output.pos[0] = (uint8_t)(strchr(order, 'R') - order);
+        output.pos[1] = (uint8_t)(strchr(order, 'G') - order);
+        output.pos[2] = (uint8_t)(strchr(order, 'B') - order);
+        output_count = o + 1;
+        first += configs[o].led_count;
+        ESP_LOGI(TAG, "Output %d: LEDs %u-%u on GPIO %d, %s", o + 1, output.first, first - 1,
+                 configs[o].gpio_num, order);
+    }
+    if (ret != ESP_OK) {
+        delete_outputs();
+    }
+    xSemaphoreGive(output_lock);
+    xSemaphoreGiveRecursive(state_lock);
+    if (ret != ESP_OK) {
+        return ret;
     }
+
+    led_strip_begin();
+    if (first_init) {
+        // Default settings; a reconfigure keeps the user's
+        power_on = true;
+        current_brightness = 64;
+        output_lut_dirty = true;
+        current_hue = 128;
+        current_saturation = 254;
+        use_temperature_mode = false;
+    }
+    state_dirty = true;
+
+    // Render the current state into the new framebuffer
+    return led_strip_commit();
 }
 
 esp_err_t led_strip_init(uint32_t gpio_num, uint16_t led_count)
 {
-    ESP_LOGI(TAG, "Initializing LED strip on GPIO %lu with %u LEDs", (unsigned long)gpio_num, led_count);
-    
-    // If already initialized, clean up first
-    if (led_strip != NULL) {
-        led_strip_del(led_strip);
-        led_strip = NULL;
-    }
-
-    strip_led_count = led_count;
-    
-    // Configure LED strip
-    led_strip_config_t strip_config = {
-        .strip_gpio_num = static_cast<int>(gpio_num),
-        .max_leds = led_count,
-        .led_model = LED_MODEL_WS2812,
+    led_output_config_t output = {
+        .gpio_num = static_cast<int>(gpio_num),
+        .led_count = led_count,
+        .order = LED_ORDER_GRB,
     };
-    
-    // Configure RMT for LED strip
-    led_strip_rmt_config_t rmt_config;
-    rmt_config.resolution_hz = 10 * 1000 * 1000; // 10MHz
-    rmt_config.flags = {
-        .with_dma = false
+    return led_strip_init_outputs(&output, 1);
+}
+
+esp_err_t led_strip_init_configured(void)
+{
+    struct {
+        int gpio_num;
+        int led_count;
+        const char *order;
+    } const configured[] = {
+        {CONFIG_LED_OUTPUT1_GPIO, CONFIG_LED_OUTPUT1_COUNT, CONFIG_LED_OUTPUT1_ORDER},
+#if CONFIG_LED_OUTPUT_COUNT >= 2
+        {CONFIG_LED_OUTPUT2_GPIO, CONFIG_LED_OUTPUT2_COUNT, CONFIG_LED_OUTPUT2_ORDER},
+#endif
+#if CONFIG_LED_OUTPUT_COUNT >= 3
+        {CONFIG_LED_OUTPUT3_GPIO, CONFIG_LED_OUTPUT3_COUNT, CONFIG_LED_OUTPUT3_ORDER},
+#endif
+#if CONFIG_LED_OUTPUT_COUNT >= 4
+        {CONFIG_LED_OUTPUT4_GPIO, CONFIG_LED_OUTPUT4_COUNT, CONFIG_LED_OUTPUT4_ORDER},
+#endif
     };
-    
-    ESP_LOGI(TAG, "Creating LED strip");
-    esp_err_t ret = led_strip_new_rmt_device(&strip_config, &rmt_config, &led_strip);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to create LED strip: %s", esp_err_to_name(ret));
-        return ret;
+    const int count = sizeof(configured) / sizeof(configured[0]);
+
+    led_output_config_t configs[count];
+    for (int o = 0; o < count; o++) {
+        configs[o].gpio_num = configured[o].gpio_num;
+        configs[o].led_count = (uint16_t)configured[o].led_count;
+        if (!led_color_order_parse(configured[o].order, &configs[o].order)) {
+            ESP_LOGW(TAG, "Output %d: unknown color order \"%s\", using GRB", o + 1, configured[o].order);
+            configs[o].order = LED_ORDER_GRB;
+        }
     }
-    
-    // Initialize with default settings
-    power_on = true;
-    current_brightness = 64;
-    current_hue = 128;
-    current_saturation = 254;
-    use_temperature_mode = false;
-    
-    // Update the strip with initial values
-    return update_led_strip();
+    return led_strip_init_outputs(configs, count);
+}
+
+int led_strip_get_outputs(led_output_config_t *out, int max)
+{
+    int count = output_count;
+    for (int o = 0; o < count && o < max; o++) {
+        out[o] = outputs[o].config;
+    }
+    return count;
 }
 
 esp_err_t led_strip_set_power(bool on)
 {
-    if (!led_strip) {
+    if (output_count == 0) {
         ESP_LOGE(TAG, "LED strip not initialized");
         return ESP_ERR_INVALID_STATE;
     }
     
-    power_on = on;
-    ESP_LOGI(TAG, "Setting LED strip power: %s", on ? "ON" : "OFF");
-    return update_led_strip();
+    led_strip_begin();
+    if (power_on != on) {
+        power_on = on;
+        state_dirty = true;
+        ESP_LOGI(TAG, "Setting LED strip power: %s", on ? "ON" : "OFF");
+    }
+    return led_strip_commit();
 }
 
 esp_err_t led_strip_set_brightness(uint8_t brightness)
 {
-    if (!led_strip) {
+    if (output_count == 0) {
         ESP_LOGE(TAG, "LED strip not initialized");
         return ESP_ERR_INVALID_STATE;
     }
     
-    ESP_LOGI(TAG, "Setting brightness: %d (previous: %d)", brightness, current_brightness);
-    current_brightness = brightness;
-    
-    return update_led_strip();
+    led_strip_begin();
+    if (current_brightness != brightness) {
+        ESP_LOGI(TAG, "Setting brightness: %d (previous: %d)", brightness, current_brightness);
+        current_brightness = brightness;
+        output_lut_dirty = true;
+        state_dirty = true;
+    }
+    return led_strip_commit();
 }
 
 esp_err_t led_strip_set_hue(uint16_t hue)
 {
-    if (!led_strip) {
+    if (output_count == 0) {
         ESP_LOGE(TAG, "LED strip not initialized");
         return ESP_ERR_INVALID_STATE;
     }
     
-    current_hue = hue;
-    use_temperature_mode = false; // Setting Hue/Sat implies color mode
-    current_mode = MODE_MANUAL;   // Switch back to manual mode
-    ESP_LOGI(TAG, "Setting LED strip hue: %d (switched to MANUAL mode)", hue);
-    return update_led_strip();
+    led_strip_begin();
+    if (current_hue != hue || use_temperature_mode || current_mode != MODE_MANUAL) {
+        current_hue = hue;
+        use_temperature_mode = false; // Setting Hue/Sat implies color mode
+        current_mode = MODE_MANUAL;   // Switch back to manual mode
+        state_dirty = true;
+        ESP_LOGI(TAG, "Setting LED strip hue: %d (switched to MANUAL mode)", hue);
+    }
+    return led_strip_commit();
 }
 
 esp_err_t led_strip_set_saturation(uint8_t saturation)
 {
-    if (!led_strip) {
+    if (output_count == 0) {
         ESP_LOGE(TAG, "LED strip not initialized");
         return ESP_ERR_INVALID_STATE;
     }
     
-    current_saturation = saturation;
-    use_temperature_mode = false; // Setting Hue/Sat implies color mode
-    current_mode = MODE_MANUAL;   // Switch back to manual mode
-    ESP_LOGI(TAG, "Setting LED strip saturation: %d (switched to MANUAL mode)", saturation);
-    return update_led_strip();
+    led_strip_begin();
+    if (current_saturation != saturation || use_temperature_mode || current_mode != MODE_MANUAL) {
+        current_saturation = saturation;
+        use_temperature_mode = false; // Setting Hue/Sat implies color mode
+        current_mode = MODE_MANUAL;   // Switch back to manual mode
+        state_dirty = true;
+        ESP_LOGI(TAG, "Setting LED strip saturation: %d (switched to MANUAL mode)", saturation);
+    }
+    return led_strip_commit();
 }
 
 esp_err_t led_strip_set_temperature(uint32_t temperature_mireds)
 {
-    if (!led_strip) {
+    if (output_count == 0) {
         ESP_LOGE(TAG, "LED strip not initialized");
         return ESP_ERR_INVALID_STATE;
     }
     
-    ESP_LOGI(TAG, "Setting temperature: %lu mireds (switched to MANUAL mode)", (unsigned long)temperature_mireds);
-    
     // Convert mireds to kelvin
-    current_temperature = mired_to_kelvin(temperature_mireds);
-    
-    // Enable temperature mode within MANUAL mode
-    use_temperature_mode = true;
-    current_mode = MODE_MANUAL; // Switch back to manual mode
-    
-    // Apply the change
-    return update_led_strip();
+    uint32_t kelvin = mired_to_kelvin(temperature_mireds);
+
+    led_strip_begin();
+    if (current_temperature != kelvin || !use_temperature_mode || current_mode != MODE_MANUAL) {
+        ESP_LOGI(TAG, "Setting temperature: %lu mireds (switched to MANUAL mode)", (unsigned long)temperature_mireds);
+        current_temperature = kelvin;
+        // Enable temperature mode within MANUAL mode
+        use_temperature_mode = true;
+        current_mode = MODE_MANUAL; // Switch back to manual mode
+        state_dirty = true;
+    }
+    return led_strip_commit();
 }
 
 esp_err_t led_strip_set_mode(led_strip_mode_t mode)
 {
-    if (!led_strip) {
+    if (output_count == 0) {
         ESP_LOGE(TAG, "LED strip not initialized");
         return ESP_ERR_INVALID_STATE;
     }
 
-    if (mode < MODE_MANUAL || mode > MODE_ENVIRONMENTAL) {
+    if (mode < MODE_MANUAL || mode >= MODE_COUNT) {
          ESP_LOGE(TAG, "Invalid mode specified: %d", mode);
          return ESP_ERR_INVALID_ARG;
     }
 
-    current_mode = mode;
-    ESP_LOGI(TAG, "Setting LED strip mode: %d", mode);
-
-    // When switching mode, update the strip immediately to reflect the new mode's state
-    // (unless switching TO adaptive, which is handled by its task)
-    if (current_mode != MODE_ADAPTIVE) {
-        ESP_LOGI(TAG, "Triggering immediate update for mode switch (not to ADAPTIVE)");
-        return update_led_strip(); // Update immediately for Manual and Environmental
-    } else {
-        ESP_LOGI(TAG, "Skipping immediate update for mode switch (to ADAPTIVE)");
+    // Switching to adaptive renders nothing here; the audio pipeline takes over the framebuffer
+    led_strip_begin();
+    if (current_mode != mode) {
+        current_mode = mode;
+        state_dirty = true;
+        ESP_LOGI(TAG, "Setting LED strip mode: %d", mode);
     }
-
-    return ESP_OK;
+    return led_strip_commit();
 }
 
 led_strip_mode_t led_strip_get_mode(void)
@@ -325,33 +875,6 @@ led_strip_mode_t led_strip_get_mode(void)
     return current_mode;
 }
 
-esp_err_t led_strip_set_pixel_color(uint16_t pixel_index, uint8_t red, uint8_t green, uint8_t blue)
-{
-    if (!led_strip) {
-        ESP_LOGE(TAG, "LED strip not initialized");
-        return ESP_ERR_INVALID_STATE;
-    }
-    
-    if (pixel_index >= strip_led_count) {
-        ESP_LOGE(TAG, "Pixel index out of range");
-        return ESP_ERR_INVALID_ARG;
-    }
-    
-    // Set pixel even if not in adaptive mode to allow for direct control
-    led_strip_set_pixel(led_strip, pixel_index, red, green, blue);
-    return ESP_OK;
-}
-
-esp_err_t led_strip_refresh(void)
-{
-    if (!led_strip) {
-        ESP_LOGE(TAG, "LED strip not initialized");
-        return ESP_ERR_INVALID_STATE;
-    }
-    
-    return led_strip_refresh(led_strip);
-}
-
 bool led_strip_get_power_state(void)
 {
     return power_on;
@@ -378,38 +901,116 @@ uint32_t led_strip_get_temperature(void)
     if (current_temperature == 0) {
         return 153; // Default to 6500K in mireds
     }
-    uint32_t mireds = 1000000 / current_temperature;
-    ESP_LOGD(TAG, "Converting %lu K to %lu mireds", 
-             (unsigned long)current_temperature, (unsigned long)mireds);
-    return mireds;
+    return 1000000 / current_temperature;
 }
 
-uint16_t led_strip_get_led_count(void)
+esp_err_t led_strip_set_white_balance(uint8_t red, uint8_t green, uint8_t blue)
 {
-    return strip_led_count;
+    if (output_count == 0) {
+        ESP_LOGE(TAG, "LED strip not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    led_strip_begin();
+    if (white_balance[0] != red || white_balance[1] != green || white_balance[2] != blue) {
+        ESP_LOGI(TAG, "Setting white balance: (%d,%d,%d)", red, green, blue);
+        white_balance[0] = red;
+        white_balance[1] = green;
+        white_balance[2] = blue;
+        output_lut_dirty = true;
+        state_dirty = true;
+    }
+    return led_strip_commit();
 }
 
-esp_err_t led_strip_update(void)
+void led_strip_get_white_balance(uint8_t *red, uint8_t *green, uint8_t *blue)
 {
-    if (!led_strip) {
-        ESP_LOGE(TAG, "LED strip not initialized");
-        return ESP_ERR_INVALID_STATE;
+    *red = white_balance[0];
+    *green = white_balance[1];
+    *blue = white_balance[2];
+}
+
+esp_err_t led_strip_set_smoothing(uint32_t attack, uint32_t release)
+{
+    if (attack > LED_SMOOTH_MAX_MS || release > LED_SMOOTH_MAX_MS) {
+        return ESP_ERR_INVALID_ARG;
     }
+    ESP_LOGI(TAG, "Setting smoothing: attack %lu ms, release %lu ms", (unsigned long)attack, (unsigned long)release);
+    attack_ms = attack;
+    release_ms = release;
+    return ESP_OK;
+}
 
-    // This function is primarily called by the adaptive task to refresh
-    // Check if still in adaptive mode before refreshing
-    if (current_mode == MODE_ADAPTIVE && power_on) {
-        ESP_LOGD(TAG, "Refreshing strip from led_strip_update (likely adaptive mode)");
-        return led_strip_refresh(led_strip);
-    } else {
-        ESP_LOGD(TAG, "Skipping refresh in led_strip_update (not adaptive/power off)");
-        return ESP_OK; // Don't refresh if not in adaptive mode or powered off
+void led_strip_get_smoothing(uint32_t *attack, uint32_t *release)
+{
+    *attack = attack_ms;
+    *release = release_ms;
+}
+
+esp_err_t led_strip_set_dither(bool enabled)
+{
+    ESP_LOGI(TAG, "Temporal dithering %s", enabled ? "on" : "off");
+    dither_enabled = enabled;
+    if (enabled) {
+        resend_pending.store(true);  // Pick up a static frame that now needs it
+        wake_render_task();
     }
+    return ESP_OK;
+}
+
+bool led_strip_get_dither(void)
+{
+    return dither_enabled;
+}
+
+esp_err_t led_strip_set_dither_hold(uint32_t hold_ms)
+{
+    if (hold_ms > LED_DITHER_HOLD_MAX_MS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ESP_LOGI(TAG, "Dither hold: %lu ms", (unsigned long)hold_ms);
+    dither_hold_ms = hold_ms;
+    resend_pending.store(true);  // Restarts the hold, so a rounded static frame is dithered again
+    wake_render_task();
+    return ESP_OK;
+}
+
+uint32_t led_strip_get_dither_hold(void)
+{
+    return dither_hold_ms;
+}
+
+void led_strip_get_output_stats(led_output_stats_t *out)
+{
+    RollingStats<64>::Summary summary;
+    uint32_t scratch[64];
+    output_time_us.summarize(&summary, scratch);
+    out->frames = output_frames.load(std::memory_order_relaxed);
+    out->frame_us_avg = summary.avg;
+    out->frame_us_p99 = summary.p99;
+    out->frame_us_max = summary.max;
+    out->refreshing = dither_active || !smooth_settled;
+    out->dithering = dither_active;
+    out->busy_waits = 0;
+    for (int o = 0; o < output_count; o++) {
+        out->busy_waits += ws2812_rmt_get_busy_waits(outputs[o].tx);
+    }
+    out->frame_rate_hz = CONFIG_LED_FRAME_RATE_HZ;
+    out->clock_running = frame_timer && esp_timer_is_active(frame_timer);
+    out->dropped_frames = dropped_frames.load(std::memory_order_relaxed);
+    render_time_us.summarize(&summary, scratch);
+    out->render_us_avg = summary.avg;
+    out->render_us_p99 = summary.p99;
+    out->render_us_max = summary.max;
+}
+
+uint16_t led_strip_get_led_count(void)
+{
+    return strip_led_count;
 }
 
 // --- Environmental Mode Logic ---
-// This function now ONLY updates the target environmental RGB values based on weather.
-// It does NOT apply them to the strip directly.
+// Updates the target environmental RGB values based on weather, as a state change
 esp_err_t led_strip_update_environmental_state(double temperature, int condition_id, const char* condition_desc) {
     ESP_LOGI(TAG, "Updating target environmental state: Temp=%.1f, CondID=%d, Desc=%s", temperature, condition_id, condition_desc);
 
@@ -441,12 +1042,15 @@ esp_err_t led_strip_update_environmental_state(double temperature, int condition
         ESP_LOGI(TAG, "Target environmental color: Default/Unknown");
     }
 
-    // Update the static variables holding the target color
-    environmental_r = r;
-    environmental_g = g;
-    environmental_b = b;
-    ESP_LOGI(TAG, "Stored environmental target RGB: (%d, %d, %d)", environmental_r, environmental_g, environmental_b);
-
-    return ESP_OK;
+    // Update the static variables holding the target color; environmental mode picks it up on the next frame
+    led_strip_begin();
+    if (environmental_r != r || environmental_g != g || environmental_b != b) {
+        environmental_r = r;
+        environmental_g = g;
+        environmental_b = b;
+        state_dirty = state_dirty || current_mode == MODE_ENVIRONMENTAL;
+        ESP_LOGI(TAG, "Stored environmental target RGB: (%d, %d, %d)", environmental_r, environmental_g, environmental_b);
+    }
+    return led_strip_commit();
 }
 // --- End Environmental Mode Logic ---
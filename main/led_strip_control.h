@@ -3,9 +3,12 @@
 #include <esp_err.h>
 #include <stdbool.h> // Ensure bool is available
 #include <stdint.h>  // Ensure standard integer types are available
+#include "freq_color_mapper.h"
 
-#define LED_COUNT 150
+#define LED_MAX_OUTPUTS 4
 #define LED_BRIGHTNESS 255
+#define LED_SMOOTH_MAX_MS 10000
+#define LED_DITHER_HOLD_MAX_MS 10000
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,11 +20,73 @@ extern "C" {
 typedef enum {
     MODE_MANUAL,        // Controlled by Matter/API (HSV, Temp)
     MODE_ADAPTIVE,      // Controlled by FFT audio analysis
-    MODE_ENVIRONMENTAL  // Controlled by external conditions (e.g., weather) - Placeholder
+    MODE_ENVIRONMENTAL, // Controlled by external conditions (e.g., weather) - Placeholder
+    MODE_EFFECT,        // Procedural effect from led_effects
+    MODE_COUNT
 } led_strip_mode_t;
 
 /**
- * @brief Initialize the WS2812B LED strip
+ * @brief Frame generator for one mode
+ *
+ * Called on the render task with the frame's timestamp (esp_timer µs) and
+ * the framebuffer, which still holds the previous frame. Writes count
+ * full-brightness colours (brightness, gamma and white balance are applied
+ * on output) and returns true if any pixel changed. Must not block.
+ */
+typedef bool (*led_frame_generator_t)(int64_t now_us, rgb_t *frame, uint16_t count, void *ctx);
+
+/**
+ * @brief Byte order a strip expects on the wire
+ */
+typedef enum {
+    LED_ORDER_GRB,      // WS2812B
+    LED_ORDER_RGB,
+    LED_ORDER_BRG,
+    LED_ORDER_RBG,
+    LED_ORDER_GBR,
+    LED_ORDER_BGR,
+} led_color_order_t;
+
+/**
+ * @brief One physical strip, on its own RMT TX channel
+ */
+typedef struct {
+    int gpio_num;               // Data line
+    uint16_t led_count;
+    led_color_order_t order;
+} led_output_config_t;
+
+/**
+ * @brief Parse "GRB", "rgb", ... into a color order
+ *
+ * @return true if name is one of the six orders
+ */
+bool led_color_order_parse(const char *name, led_color_order_t *order);
+
+const char *led_color_order_name(led_color_order_t order);
+
+/**
+ * @brief Initialize the WS2812B outputs
+ *
+ * Every mode renders into one logical framebuffer of the outputs' total
+ * length; output 0 shows its first led_count LEDs, output 1 the next, and
+ * so on. Each frame is handed to all outputs back to back, so the strips
+ * transmit in parallel and a frame takes as long on the wire as the longest
+ * output. Can be called again to reconfigure; power, brightness and colour
+ * are set to their defaults on the first call only.
+ *
+ * @param outputs 1 to LED_MAX_OUTPUTS outputs, on distinct GPIOs
+ * @return esp_err_t ESP_OK on success, otherwise error
+ */
+esp_err_t led_strip_init_outputs(const led_output_config_t *outputs, int count);
+
+/**
+ * @brief Initialize the outputs set under "LED output" in menuconfig
+ */
+esp_err_t led_strip_init_configured(void);
+
+/**
+ * @brief Initialize a single GRB WS2812B strip
  * 
  * @param gpio_num GPIO pin connected to the data line of the WS2812B LED strip
  * @param led_count Number of LEDs in the strip
@@ -29,6 +94,14 @@ typedef enum {
  */
 esp_err_t led_strip_init(uint32_t gpio_num, uint16_t led_count);
 
+/**
+ * @brief Copy the current outputs' configuration
+ *
+ * @param out Receives up to max outputs
+ * @return int Number of outputs in use
+ */
+int led_strip_get_outputs(led_output_config_t *out, int max);
+
 /**
  * @brief Set the power state of the LED strip
  * 
@@ -46,6 +119,8 @@ bool led_strip_get_power_state(void);
 
 /**
  * @brief Set the brightness of the LED strip
+ *
+ * Applied to every mode in the output stage, on a perceptual (gamma) scale.
  * 
  * @param brightness Brightness value (0-255)
  * @return esp_err_t ESP_OK on success
@@ -130,40 +205,137 @@ led_strip_mode_t led_strip_get_mode(void);
 esp_err_t led_strip_update_environmental_state(double temperature, int condition_id, const char* condition_desc);
 
 /**
- * @brief Set the color of an individual pixel (for use by FFT algorithm)
- * 
- * @param pixel_index Index of the pixel to set
- * @param red Red component (0-255)
- * @param green Green component (0-255)
- * @param blue Blue component (0-255)
+ * @brief Set the white-balance correction applied to every frame
+ *
+ * Each channel is scaled by value/255 after gamma, so full white can be
+ * trimmed to look neutral on a given strip.
+ *
  * @return esp_err_t ESP_OK on success
  */
-esp_err_t led_strip_set_pixel_color(uint16_t pixel_index, uint8_t red, uint8_t green, uint8_t blue);
+esp_err_t led_strip_set_white_balance(uint8_t red, uint8_t green, uint8_t blue);
+
+void led_strip_get_white_balance(uint8_t *red, uint8_t *green, uint8_t *blue);
 
 /**
- * @brief Refresh the LED strip to display set colors
- * 
+ * @brief Set the per-LED smoothing time constants
+ *
+ * Every channel of every LED eases towards its new value, with attack for
+ * rising and release for falling values. 0 switches that direction off.
+ * Applies to all modes, including manual and environmental changes.
+ *
+ * @param attack Rise time constant in ms (0-LED_SMOOTH_MAX_MS)
+ * @param release Fall time constant in ms (0-LED_SMOOTH_MAX_MS)
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG if out of range
+ */
+esp_err_t led_strip_set_smoothing(uint32_t attack, uint32_t release);
+
+void led_strip_get_smoothing(uint32_t *attack, uint32_t *release);
+
+/**
+ * @brief Enable temporal dithering of the 8-bit output
+ *
+ * The output stage works in 16 bits; with dithering on, each channel's
+ * rounding error is carried into the next frame, and the strip is
+ * refreshed at CONFIG_LED_FRAME_RATE_HZ while any channel needs it, static
+ * frames included unless a dither hold is set.
+ *
+ * @param enabled true to dither, false to round
  * @return esp_err_t ESP_OK on success
  */
-esp_err_t led_strip_update(void);
+esp_err_t led_strip_set_dither(bool enabled);
+
+bool led_strip_get_dither(void);
+
+/**
+ * @brief Stop dithering a frame once it has been static this long
+ *
+ * After hold_ms of settled, unchanged output the frame is rounded to 8 bits
+ * and the frame clock stops. At low levels that can show as a step of up
+ * to half an output level. 0 keeps dithering static frames, and so keeps
+ * the strip refreshing, for as long as any channel sits between two levels.
+ *
+ * @param hold_ms 0-LED_DITHER_HOLD_MAX_MS
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG if out of range
+ */
+esp_err_t led_strip_set_dither_hold(uint32_t hold_ms);
+
+uint32_t led_strip_get_dither_hold(void);
+
+typedef struct {
+    uint32_t frames;         // Frames sent since boot
+    uint32_t frame_us_avg;   // Output stage time over the last 64 frames (smoothing, tables, dithering)
+    uint32_t frame_us_p99;
+    uint32_t frame_us_max;   // Since boot
+    bool refreshing;         // A fade or the dithering is keeping the frame clock running
+    bool dithering;          // The last frame was dithered, with channels between two levels
+    uint32_t busy_waits;     // Frames that had to wait for the previous one to leave the wire
+    uint32_t frame_rate_hz;  // Render clock rate
+    bool clock_running;      // False while the output is static and the render task sleeps
+    uint32_t dropped_frames; // Ticks missed because the previous frame was still rendering
+    uint32_t render_us_avg;  // Generator plus output stage over the last 64 frames sent
+    uint32_t render_us_p99;
+    uint32_t render_us_max;  // Since boot
+} led_output_stats_t;
+
+void led_strip_get_output_stats(led_output_stats_t *out);
 
 /**
- * @brief Get the number of LEDs in the strip
+ * @brief Install the frame generator for a mode
+ *
+ * Animated generators are called on every frame tick while their mode is
+ * active; the others only after a state change or led_strip_request_frame().
+ * Manual and environmental mode have built-in generators.
+ *
+ * @return esp_err_t ESP_OK, or ESP_ERR_INVALID_ARG for an unknown mode
+ */
+esp_err_t led_strip_set_generator(led_strip_mode_t mode, led_frame_generator_t generator, void *ctx,
+                                  bool animated);
+
+/**
+ * @brief Tell the render task a non-animated generator has new input
+ *
+ * The generator is called on the next frame tick. Safe from any task.
+ */
+void led_strip_request_frame(void);
+
+/**
+ * @brief Get the number of LEDs in the framebuffer, across all outputs
  * 
  * @return uint16_t Number of LEDs
  */
 uint16_t led_strip_get_led_count(void);
 
 /**
- * @brief Update the LED strip display based on the current mode and settings.
+ * @brief Re-render the LED strip from the current mode and settings.
  *
- * This function reads the current mode, power, brightness, and color settings
- * (including the target environmental color) and applies them to the physical LED strip.
+ * Marks the state dirty and commits it. The render happens on the render
+ * task; this does not block on the strip.
  *
  * @return esp_err_t ESP_OK on success.
  */
 esp_err_t update_led_strip(void);
 
+/**
+ * @brief Start a state transaction
+ *
+ * Setters called until the matching led_strip_commit() only change the
+ * state; the strip is rendered once, at the outermost commit, and only if
+ * something changed. Transactions nest and hold a lock, so keep them short
+ * and always pair them.
+ */
+void led_strip_begin(void);
+
+/**
+ * @brief End a state transaction
+ *
+ * The outermost commit of a changed state queues one render on the refresh
+ * task, which folds commits arriving within one refresh period together and
+ * skips the output when the rendered frame is unchanged.
+ *
+ * @return esp_err_t ESP_OK
+ */
+esp_err_t led_strip_commit(void);
+
 #ifdef __cplusplus
 }
 #endif
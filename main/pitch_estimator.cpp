@@ -0,0 +1,110 @@
+#include "pitch_estimator.h"
+#include "spectrum_kernels.h"
+#include <math.h>
+
+// Harmonic-product-spectrum check: subharmonics tried and harmonics multiplied
+#define HPS_MAX_DIVISOR 3
+#define HPS_HARMONICS 3
+// A subharmonic must carry at least this fraction of the peak to be a candidate
+#define HPS_MIN_RATIO 0.15f
+// ...and sit outside the peak's own main lobe (Hann: +-2 bins)
+#define HPS_MIN_SEPARATION 2.5f
+// Keeps log() finite on empty bins
+#define MAG_EPSILON 1e-6f
+
+// Fractional offset (-0.5..0.5) and height of the peak through bins k-1, k, k+1
+static void interpolate_peak(const float *mag, int k, pitch_interp_t interp, float *offset, float *height) {
+    float a = mag[k - 1];
+    float b = mag[k];
+    float c = mag[k + 1];
+    *offset = 0.0f;
+    *height = b;
+
+    if (interp == PITCH_INTERP_GAUSSIAN) {
+        a = logf(a + MAG_EPSILON);
+        b = logf(b + MAG_EPSILON);
+        c = logf(c + MAG_EPSILON);
+    } else if (interp != PITCH_INTERP_QUADRATIC) {
+        return;
+    }
+
+    float denom = a - 2.0f * b + c;
+    if (denom >= 0.0f) {
+        return;  // Not a local maximum in this domain
+    }
+    float p = 0.5f * (a - c) / denom;
+    float peak = b - 0.25f * (a - c) * p;
+
+    *offset = p;
+    *height = (interp == PITCH_INTERP_GAUSSIAN) ? expf(peak) - MAG_EPSILON : peak;
+}
+
+// Largest magnitude within one bin of a fractional position
+static float sample_near(const float *mag, uint16_t num_bins, float pos) {
+    int k = (int)lrintf(pos);
+    if (k < 1 || k >= num_bins - 1) {
+        return MAG_EPSILON;
+    }
+    float m = mag[k];
+    if (mag[k - 1] > m) m = mag[k - 1];
+    if (mag[k + 1] > m) m = mag[k + 1];
+    return m;
+}
+
+static float hps_score(const float *mag, uint16_t num_bins, float f0_bins) {
+    float score = 0.0f;
+    for (int r = 1; r <= HPS_HARMONICS; r++) {
+        score += logf(sample_near(mag, num_bins, f0_bins * r) + MAG_EPSILON);
+    }
+    return score;
+}
+
+void pitch_estimate(const float *mag, uint16_t num_bins, float bin_hz, pitch_interp_t interp,
+                    bool use_hps, pitch_estimate_t *out) {
+    // Argmax above DC; the last bin has no right neighbour for interpolation
+    float max_value;
+    int max_index = 1 + spectrum_argmax(mag + 1, num_bins - 2, &max_value);
+
+    float offset, height;
+    interpolate_peak(mag, max_index, interp, &offset, &height);
+    float peak_bins = max_index + offset;
+
+    out->freq_hz = peak_bins * bin_hz;
+    out->magnitude = height;
+    out->harmonic = 1;
+
+    if (!use_hps || max_value <= 0.0f) {
+        return;
+    }
+
+    float best_score = hps_score(mag, num_bins, peak_bins);
+    for (int h = 2; h <= HPS_MAX_DIVISOR; h++) {
+        float f0 = peak_bins / h;
+        int k = (int)lrintf(f0);
+        if (k < 1) {
+            break;
+        }
+        if (peak_bins - f0 < HPS_MIN_SEPARATION) {
+            continue;
+        }
+
+        // The subharmonic has to be a peak of its own, not leakage from a neighbour
+        if (k + 1 < num_bins - 1 && mag[k + 1] > mag[k]) k++;
+        else if (k - 1 >= 1 && mag[k - 1] > mag[k]) k--;
+        if (mag[k] < mag[k - 1] || mag[k] < mag[k + 1] || mag[k] < HPS_MIN_RATIO * max_value) {
+            continue;
+        }
+
+        float score = hps_score(mag, num_bins, f0);
+        if (score > best_score) {
+            best_score = score;
+
+            float sub_offset, sub_height;
+            interpolate_peak(mag, k, interp, &sub_offset, &sub_height);
+
+            out->freq_hz = (k + sub_offset) * bin_hz;
+            out->magnitude = sub_height;
+            out->harmonic = (uint8_t)h;
+        }
+    }
+}
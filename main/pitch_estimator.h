@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Sub-bin interpolation applied around the spectral peak
+ */
+typedef enum {
+    PITCH_INTERP_NONE,       // Plain argmax bin
+    PITCH_INTERP_QUADRATIC,  // Parabola through the peak and its neighbours
+    PITCH_INTERP_GAUSSIAN    // Parabola through log magnitudes (exact for Gaussian-shaped peaks)
+} pitch_interp_t;
+
+/**
+ * @brief Result of a pitch estimate
+ */
+typedef struct {
+    float freq_hz;      // Estimated fundamental
+    float magnitude;    // Interpolated peak magnitude at the chosen partial
+    uint8_t harmonic;   // 1 if the strongest peak was kept, >1 if HPS moved to a subharmonic
+} pitch_estimate_t;
+
+/**
+ * @brief Estimate the dominant pitch of a magnitude spectrum
+ *
+ * Finds the strongest bin above DC, refines its position to a fraction of
+ * a bin and, if enabled, runs a harmonic-product-spectrum check over the
+ * first few subharmonics so a loud overtone does not win over its
+ * fundamental. No allocation, no ESP-IDF dependencies.
+ *
+ * @param mag Magnitude spectrum, num_bins values starting at DC
+ * @param num_bins Number of bins (FFT size / 2)
+ * @param bin_hz Width of one bin in Hz
+ * @param interp Interpolation method
+ * @param use_hps Enable the harmonic-product-spectrum check
+ * @param out Result
+ */
+void pitch_estimate(const float *mag, uint16_t num_bins, float bin_hz, pitch_interp_t interp,
+                    bool use_hps, pitch_estimate_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Rolling min/avg/p99 over the last Window values of one series
+ *
+ * One task records, any task reads, and neither takes a lock: each value
+ * is a single atomic word and the write count is published with release
+ * ordering. A reader racing the writer may see one value from the next
+ * lap of the window, which does not matter for statistics. Recording is a
+ * couple of stores, cheap enough to leave on in production.
+ *
+ * The summary is computed by the reader (a copy and an nth_element over
+ * the window), so it costs nothing on the recording side.
+ */
+template <size_t Window>
+class RollingStats {
+    static_assert(Window >= 2, "Window too small");
+
+public:
+    struct Summary {
+        uint32_t last;
+        uint32_t min;
+        uint32_t avg;
+        uint32_t p99;
+        uint32_t max;      // Since the last reset, not just the window
+        uint32_t count;    // Values in the window
+    };
+
+    // Writer side
+    void record(uint32_t value)
+    {
+        uint32_t n = count_.load(std::memory_order_relaxed);
+        values_[n % Window].store(value, std::memory_order_relaxed);
+        if (value > max_.load(std::memory_order_relaxed)) {
+            max_.store(value, std::memory_order_relaxed);
+        }
+        count_.store(n + 1, std::memory_order_release);
+    }
+
+    // Safe from any task; the writer's next record() starts the new window
+    void reset()
+    {
+        count_.store(0, std::memory_order_release);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    // Reader side. scratch must hold Window values.
+    void summarize(Summary *out, uint32_t *scratch) const
+    {
+        uint32_t total = count_.load(std::memory_order_acquire);
+        uint32_t n = total < Window ? total : (uint32_t)Window;
+        *out = Summary{};
+        out->count = n;
+        out->max = max_.load(std::memory_order_relaxed);
+        if (n == 0) {
+            return;
+        }
+        out->last = values_[(total - 1) % Window].load(std::memory_order_relaxed);
+
+        uint64_t sum = 0;
+        uint32_t lo = UINT32_MAX;
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t v = values_[i].load(std::memory_order_relaxed);
+            scratch[i] = v;
+            sum += v;
+            lo = v < lo ? v : lo;
+        }
+        out->min = lo;
+        out->avg = (uint32_t)(sum / n);
+
+        // Nearest-rank 99th percentile
+        uint32_t rank = (uint32_t)((99u * n + 99) / 100) - 1;
+        std::nth_element(scratch, scratch + rank, scratch + n);
+        out->p99 = scratch[rank];
+    }
+
+private:
+    std::atomic<uint32_t> values_[Window] = {};
+    std::atomic<uint32_t> count_{0};
+    std::atomic<uint32_t> max_{0};
+};
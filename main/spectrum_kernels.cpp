@@ -0,0 +1,363 @@
+#include "spectrum_kernels.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_cpu.h"
+#include "esp_dsp.h"
+#include "sdkconfig.h"
+
+// esp-dsp's vector routines exist for the Xtensa cores only; elsewhere (and
+// on the host build) the unrolled C loops below are used
+#if dsps_mul_f32_ae32_enabled && dsps_add_f32_ae32_enabled
+#define SPECTRUM_DSP_VECTOR 1
+#else
+#define SPECTRUM_DSP_VECTOR 0
+#endif
+
+#if dsps_dotprod_f32_aes3_enabled
+#define SPECTRUM_DSP_DOT_NAME "aes3"
+#elif dsps_dotprod_f32_ae32_enabled
+#define SPECTRUM_DSP_DOT_NAME "ae32"
+#else
+#define SPECTRUM_DSP_DOT_NAME "C"
+#endif
+
+#define SPECTRUM_BENCH_MAX_LEN 1024
+
+// Stops the compiler from hoisting a benchmarked call out of its loop
+#define BENCH_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+static inline bool aligned16(const void *p) {
+    return ((uintptr_t)p & 15) == 0;
+}
+
+void spectrum_window(const int16_t *x, const float *w, float gain, float *out, int len) {
+#if SPECTRUM_DSP_VECTOR
+    // The int16 conversion has no esp-dsp routine; the multiply does
+    for (int i = 0; i < len; i++) {
+        out[i] = (float)x[i] * gain;
+    }
+    dsps_mul_f32_ae32(out, w, out, len, 1, 1, 1);
+#else
+    int i = 0;
+    for (; i + 4 <= len; i += 4) {
+        out[i] = (float)x[i] * (w[i] * gain);
+        out[i + 1] = (float)x[i + 1] * (w[i + 1] * gain);
+        out[i + 2] = (float)x[i + 2] * (w[i + 2] * gain);
+        out[i + 3] = (float)x[i + 3] * (w[i + 3] * gain);
+    }
+    for (; i < len; i++) {
+        out[i] = (float)x[i] * (w[i] * gain);
+    }
+#endif
+}
+
+void spectrum_power(float *cplx, float *power, int bins) {
+#if SPECTRUM_DSP_VECTOR
+    // Square every component in place, then add re/im neighbours with a stride of two
+    dsps_mul_f32_ae32(cplx, cplx, cplx, 2 * bins, 1, 1, 1);
+    dsps_add_f32_ae32(cplx, cplx + 1, power, bins, 2, 2, 1);
+#else
+    int k = 0;
+    for (; k + 2 <= bins; k += 2) {
+        const float *c = cplx + 2 * k;
+        power[k] = c[0] * c[0] + c[1] * c[1];
+        power[k + 1] = c[2] * c[2] + c[3] * c[3];
+    }
+    for (; k < bins; k++) {
+        power[k] = cplx[2 * k] * cplx[2 * k] + cplx[2 * k + 1] * cplx[2 * k + 1];
+    }
+#endif
+}
+
+void spectrum_magnitude(const float *power, float *mag, int bins) {
+    // No full-precision vector square root in esp-dsp (dsps_sqrt_f32 is a
+    // ~3% bit-trick estimate, too coarse for peak interpolation)
+    int k = 0;
+    for (; k + 4 <= bins; k += 4) {
+        mag[k] = sqrtf(power[k]);
+        mag[k + 1] = sqrtf(power[k + 1]);
+        mag[k + 2] = sqrtf(power[k + 2]);
+        mag[k + 3] = sqrtf(power[k + 3]);
+    }
+    for (; k < bins; k++) {
+        mag[k] = sqrtf(power[k]);
+    }
+}
+
+// log2 of v >= 1: exponent from the float bits plus a degree-6 least-squares
+// polynomial for the mantissa (max error 4.4e-6 on [1, 2))
+static inline float fast_log2(float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    float exponent = (float)((int32_t)(bits >> 23) - 127);
+    bits = (bits & 0x007FFFFF) | 0x3F800000;
+    float m;
+    memcpy(&m, &bits, sizeof(m));
+    float t = m - 1.0f;
+    float p = -0.0260617976f;
+    p = p * t + 0.121902014f;
+    p = p * t - 0.277352926f;
+    p = p * t + 0.456888664f;
+    p = p * t - 0.717897279f;
+    p = p * t + 1.44251696f;
+    return exponent + p * t;
+}
+
+void spectrum_log1p(const float *x, float gain, float *out, int len) {
+    const float ln2 = 0.693147181f;
+    for (int i = 0; i < len; i++) {
+        out[i] = fast_log2(1.0f + gain * x[i]) * ln2;
+    }
+}
+
+float spectrum_dot(const float *a, const float *b, int len) {
+    float result = 0.0f;
+#if dsps_dotprod_f32_aes3_enabled
+    // The S3 kernel wants aligned inputs; filterbank spans start anywhere
+    if (aligned16(a) && aligned16(b)) {
+        dsps_dotprod_f32_aes3(a, b, &result, len);
+    } else {
+        dsps_dotprod_f32_ae32(a, b, &result, len);
+    }
+#elif dsps_dotprod_f32_ae32_enabled
+    dsps_dotprod_f32_ae32(a, b, &result, len);
+#else
+    float acc0 = 0.0f, acc1 = 0.0f, acc2 = 0.0f, acc3 = 0.0f;
+    int i = 0;
+    for (; i + 4 <= len; i += 4) {
+        acc0 += a[i] * b[i];
+        acc1 += a[i + 1] * b[i + 1];
+        acc2 += a[i + 2] * b[i + 2];
+        acc3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < len; i++) {
+        acc0 += a[i] * b[i];
+    }
+    result = (acc0 + acc1) + (acc2 + acc3);
+#endif
+    return result;
+}
+
+int spectrum_argmax(const float *x, int len, float *max_out) {
+    if (len <= 0) {
+        *max_out = 0.0f;
+        return -1;
+    }
+
+    // No esp-dsp routine for this; four independent lanes keep the FPU's
+    // compare latency off the critical path, then the lanes are merged
+    int i = 0;
+    int best = 0;
+    float best_value = x[0];
+    if (len >= 4) {
+        float v0 = x[0], v1 = x[1], v2 = x[2], v3 = x[3];
+        int i0 = 0, i1 = 1, i2 = 2, i3 = 3;
+        for (i = 4; i + 4 <= len; i += 4) {
+            if (x[i] > v0) { v0 = x[i]; i0 = i; }
+            if (x[i + 1] > v1) { v1 = x[i + 1]; i1 = i + 1; }
+            if (x[i + 2] > v2) { v2 = x[i + 2]; i2 = i + 2; }
+            if (x[i + 3] > v3) { v3 = x[i + 3]; i3 = i + 3; }
+        }
+        best = i0;
+        best_value = v0;
+        const float lane_value[3] = { v1, v2, v3 };
+        const int lane_index[3] = { i1, i2, i3 };
+        for (int l = 0; l < 3; l++) {
+            if (lane_value[l] > best_value || (lane_value[l] == best_value && lane_index[l] < best)) {
+                best_value = lane_value[l];
+                best = lane_index[l];
+            }
+        }
+    } else {
+        i = 1;
+    }
+    for (; i < len; i++) {
+        if (x[i] > best_value) {
+            best_value = x[i];
+            best = i;
+        }
+    }
+    *max_out = best_value;
+    return best;
+}
+
+// Plain scalar versions: the baseline the benchmark compares against
+__attribute__((noinline)) static void ref_window(const int16_t *x, const float *w, float gain, float *out, int len) {
+    for (int i = 0; i < len; i++) {
+        out[i] = (float)x[i] * w[i] * gain;
+    }
+}
+
+__attribute__((noinline)) static void ref_magnitude(const float *cplx, float *mag, int bins) {
+    for (int k = 0; k < bins; k++) {
+        mag[k] = sqrtf(cplx[2 * k] * cplx[2 * k] + cplx[2 * k + 1] * cplx[2 * k + 1]);
+    }
+}
+
+__attribute__((noinline)) static void ref_log1p(const float *x, float gain, float *out, int len) {
+    for (int i = 0; i < len; i++) {
+        out[i] = logf(1.0f + gain * x[i]);
+    }
+}
+
+__attribute__((noinline)) static float ref_dot(const float *a, const float *b, int len) {
+    float sum = 0.0f;
+    for (int i = 0; i < len; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+__attribute__((noinline)) static int ref_argmax(const float *x, int len, float *max_out) {
+    int best = 0;
+    for (int i = 1; i < len; i++) {
+        if (x[i] > x[best]) {
+            best = i;
+        }
+    }
+    *max_out = x[best];
+    return best;
+}
+
+static void print_row(const char *name, uint32_t ref, uint32_t opt, float err) {
+    printf("  %-18s %9lu %9lu  %5.2fx  max err %.2g\n", name, (unsigned long)ref, (unsigned long)opt,
+           opt > 0 ? (float)ref / opt : 0.0f, err);
+}
+
+static float max_abs_diff(const float *a, const float *b, int len) {
+    float worst = 0.0f;
+    for (int i = 0; i < len; i++) {
+        worst = fmaxf(worst, fabsf(a[i] - b[i]) / fmaxf(1.0f, fabsf(b[i])));
+    }
+    return worst;
+}
+
+void spectrum_kernels_benchmark(int len, int iterations) {
+    if (len <= 0 || len > SPECTRUM_BENCH_MAX_LEN) {
+        len = SPECTRUM_BENCH_MAX_LEN;
+    }
+    len &= ~3;
+    if (iterations <= 0) {
+        iterations = 100;
+    }
+
+    const size_t fbytes = 2 * SPECTRUM_BENCH_MAX_LEN * sizeof(float);
+    float *a = (float *)aligned_alloc(16, fbytes);
+    float *b = (float *)aligned_alloc(16, fbytes);
+    float *out_ref = (float *)aligned_alloc(16, fbytes);
+    float *out = (float *)aligned_alloc(16, fbytes);
+    int16_t *pcm = (int16_t *)aligned_alloc(16, SPECTRUM_BENCH_MAX_LEN * sizeof(int16_t));
+    if (!a || !b || !out_ref || !out || !pcm) {
+        printf("Kernel benchmark: out of memory\n");
+        free(a);
+        free(b);
+        free(out_ref);
+        free(out);
+        free(pcm);
+        return;
+    }
+
+    // Deterministic pseudo-random test data
+    uint32_t seed = 12345;
+    for (int i = 0; i < 2 * len; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        a[i] = (float)(seed >> 8) / (float)(1 << 24) * 2.0f - 1.0f;
+        b[i] = 0.5f + 0.5f * a[i] * a[i];
+    }
+    for (int i = 0; i < len; i++) {
+        pcm[i] = (int16_t)(a[i] * 2047.0f);
+    }
+
+    printf("Spectrum kernels on %s, %d elements, %d runs (cycles per call; vector ops: %s, dot: %s):\n",
+           CONFIG_IDF_TARGET, len, iterations, SPECTRUM_DSP_VECTOR ? "esp-dsp" : "C", SPECTRUM_DSP_DOT_NAME);
+    printf("  %-18s %9s %9s  %6s\n", "kernel", "scalar", "kernel", "speedup");
+
+    uint32_t start, ref_cycles, opt_cycles;
+    volatile float sink = 0.0f;
+
+    start = esp_cpu_get_cycle_count();
+    for (int n = 0; n < iterations; n++) {
+        ref_window(pcm, b, 0.001f, out_ref, len);
+        BENCH_BARRIER();
+    }
+    ref_cycles = (esp_cpu_get_cycle_count() - start) / iterations;
+    start = esp_cpu_get_cycle_count();
+    for (int n = 0; n < iterations; n++) {
+        spectrum_window(pcm, b, 0.001f, out, len);
+        BENCH_BARRIER();
+    }
+    opt_cycles = (esp_cpu_get_cycle_count() - start) / iterations;
+    print_row("window", ref_cycles, opt_cycles, max_abs_diff(out, out_ref, len));
+
+    // Power clobbers its input, so both sides pay for restoring it
+    const int bins = len / 2;
+    start = esp_cpu_get_cycle_count();
+    for (int n = 0; n < iterations; n++) {
+        memcpy(out, a, len * sizeof(float));
+        ref_magnitude(out, out_ref, bins);
+    }
+    ref_cycles = (esp_cpu_get_cycle_count() - start) / iterations;
+    start = esp_cpu_get_cycle_count();
+    for (int n = 0; n < iterations; n++) {
+        memcpy(out, a, len * sizeof(float));
+        spectrum_power(out, out + len, bins);
+        spectrum_magnitude(out + len, out, bins);
+    }
+    opt_cycles = (esp_cpu_get_cycle_count() - start) / iterations;
+    print_row("power + magnitude", ref_cycles, opt_cycles, max_abs_diff(out, out_ref, bins));
+
+    start = esp_cpu_get_cycle_count();
+    for (int n = 0; n < iterations; n++) {
+        ref_log1p(b, 100.0f, out_ref, len);
+        BENCH_BARRIER();
+    }
+    ref_cycles = (esp_cpu_get_cycle_count() - start) / iterations;
+    start = esp_cpu_get_cycle_count();
+    for (int n = 0; n < iterations; n++) {
+        spectrum_log1p(b, 100.0f, out, len);
+        BENCH_BARRIER();
+    }
+    opt_cycles = (esp_cpu_get_cycle_count() - start) / iterations;
+    print_row("log1p", ref_cycles, opt_cycles, max_abs_diff(out, out_ref, len));
+
+    float ref_sum = 0.0f, opt_sum = 0.0f;
+    start = esp_cpu_get_cycle_count();
+    for (int n = 0; n < iterations; n++) {
+        ref_sum = ref_dot(a, b, len);
+        BENCH_BARRIER();
+    }
+    ref_cycles = (esp_cpu_get_cycle_count() - start) / iterations;
+    start = esp_cpu_get_cycle_count();
+    for (int n = 0; n < iterations; n++) {
+        opt_sum = spectrum_dot(a, b, len);
+        BENCH_BARRIER();
+    }
+    opt_cycles = (esp_cpu_get_cycle_count() - start) / iterations;
+    print_row("dot (band sum)", ref_cycles, opt_cycles, fabsf(opt_sum - ref_sum) / fmaxf(1.0f, fabsf(ref_sum)));
+
+    float ref_max = 0.0f, opt_max = 0.0f;
+    int ref_idx = 0, opt_idx = 0;
+    start = esp_cpu_get_cycle_count();
+    for (int n = 0; n < iterations; n++) {
+        ref_idx = ref_argmax(b, len, &ref_max);
+        BENCH_BARRIER();
+    }
+    ref_cycles = (esp_cpu_get_cycle_count() - start) / iterations;
+    start = esp_cpu_get_cycle_count();
+    for (int n = 0; n < iterations; n++) {
+        opt_idx = spectrum_argmax(b, len, &opt_max);
+        BENCH_BARRIER();
+    }
+    opt_cycles = (esp_cpu_get_cycle_count() - start) / iterations;
+    print_row("argmax", ref_cycles, opt_cycles, (ref_idx == opt_idx && ref_max == opt_max) ? 0.0f : 1.0f);
+
+    sink = ref_sum + opt_sum;
+    (void)sink;
+    free(a);
+    free(b);
+    free(out_ref);
+    free(out);
+    free(pcm);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Vector kernels for the per-frame spectrum work
+ *
+ * Each kernel runs on esp-dsp's accelerated routines where the chip has
+ * them (ae32 on the ESP32, aes3/PIE on the ESP32-S3) and on an unrolled
+ * portable C loop everywhere else. Buffers passed in should be 16-byte
+ * aligned (alignas(16)); the S3 routines fall back to slower code or
+ * the ae32 kernels otherwise.
+ */
+
+// out[i] = x[i] * w[i] * gain
+void spectrum_window(const int16_t *x, const float *w, float gain, float *out, int len);
+
+// power[k] = re^2 + im^2 of the interleaved complex bins. Clobbers cplx.
+void spectrum_power(float *cplx, float *power, int bins);
+
+// mag[k] = sqrt(power[k])
+void spectrum_magnitude(const float *power, float *mag, int bins);
+
+// out[i] = ln(1 + gain * x[i]) for x[i] >= 0, within 4e-6 of logf
+void spectrum_log1p(const float *x, float gain, float *out, int len);
+
+// sum of a[i] * b[i]
+float spectrum_dot(const float *a, const float *b, int len);
+
+// Index of the largest value (the first one on ties), and the value
+int spectrum_argmax(const float *x, int len, float *max_out);
+
+/**
+ * @brief Time each kernel against a plain scalar loop and print the speedup
+ *
+ * @param len Vector length (clamped to the FFT size)
+ * @param iterations Runs per kernel
+ */
+void spectrum_kernels_benchmark(int len, int iterations);
+
+#ifdef __cplusplus
+}
+#endif
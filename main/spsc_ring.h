@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Lock-free single-producer/single-consumer ring
+ *
+ * One task may push and one (other) task may pop, on any core, without
+ * critical sections: each index is written by exactly one side and
+ * published with release/acquire ordering, so a slot is never read before
+ * its contents are complete. Capacity must be a power of two; one slot is
+ * never used so that full and empty can be told apart.
+ */
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Producer side. Returns false (and drops item) when the ring is full.
+    bool push(const T &item)
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t next = (head + 1) & (Capacity - 1);
+        if (next == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        slots_[head] = item;
+        head_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false when the ring is empty.
+    bool pop(T *out)
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        *out = slots_[tail];
+        tail_.store((tail + 1) & (Capacity - 1), std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called from a third task
+    size_t size() const
+    {
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        return (head - tail) & (Capacity - 1);
+    }
+
+private:
+    T slots_[Capacity];
+    std::atomic<size_t> head_{0};   // Next slot to write, owned by the producer
+    std::atomic<size_t> tail_{0};   // Next slot to read, owned by the consumer
+};
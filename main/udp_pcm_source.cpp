@@ -0,0 +1,221 @@
+#include "udp_pcm_source.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/stream_buffer.h"
+#include "sdkconfig.h"
+#include <string.h>
+
+static const char *TAG = "udp_pcm";
+
+#define RX_TASK_STACK 3072
+#define RX_TASK_PRIORITY 5          // Below the audio task, which drains the buffer
+#define RX_POLL_MS 100              // Socket timeout, bounds how long close() waits
+
+// 16-bit network samples to the 12-bit swing the analysis expects
+#define SAMPLE_SHIFT 4
+
+static int sock = -1;
+static StreamBufferHandle_t jitter_buffer = NULL;
+static TaskHandle_t rx_task = NULL;
+static volatile bool running = false;
+static uint32_t stream_rate_hz = 0;
+
+// Whole packet, header included; samples are scaled in place before buffering.
+// The header is packed (alignment 1), so the buffer is aligned for int16_t
+// itself and the header size keeps the samples after it aligned too.
+static_assert(sizeof(udp_pcm_header_t) % alignof(int16_t) == 0, "samples must follow the header aligned");
+alignas(int16_t) static uint8_t packet[sizeof(udp_pcm_header_t) + UDP_PCM_MAX_SAMPLES * sizeof(int16_t)];
+
+// Counters
+static uint32_t frame_count = 0;
+static volatile uint32_t overrun_count = 0;
+static uint32_t underrun_count = 0;
+static volatile uint32_t lost_count = 0;
+
+static void handle_packet(size_t len, bool *have_seq, uint32_t *expected_seq, bool *rate_warned)
+{
+    udp_pcm_header_t header;
+    size_t payload = len - sizeof(header);
+    if (len < sizeof(header) || (payload % sizeof(int16_t)) != 0) {
+        return;
+    }
+    memcpy(&header, packet, sizeof(header));
+    if (header.magic != UDP_PCM_MAGIC) {
+        return;
+    }
+    if (header.sample_rate_hz != stream_rate_hz) {
+        if (!*rate_warned) {
+            ESP_LOGW(TAG, "Dropping %lu Hz stream, analysis runs at %lu Hz",
+                     (unsigned long)header.sample_rate_hz, (unsigned long)stream_rate_hz);
+            *rate_warned = true;
+        }
+        return;
+    }
+
+    // A jump backwards is a restarted sender, not loss
+    if (*have_seq) {
+        int32_t gap = (int32_t)(header.seq - *expected_seq);
+        if (gap > 0) {
+            lost_count = lost_count + (uint32_t)gap;
+        }
+    }
+    *have_seq = true;
+    *expected_seq = header.seq + 1;
+
+    int16_t *samples = (int16_t *)(packet + sizeof(header));
+    size_t count = payload / sizeof(int16_t);
+    for (size_t i = 0; i < count; i++) {
+        samples[i] = (int16_t)(samples[i] >> SAMPLE_SHIFT);
+    }
+
+    // Whole packets only, so the buffer never holds half a sample
+    if (xStreamBufferSpacesAvailable(jitter_buffer) < payload) {
+        overrun_count = overrun_count + 1;
+        return;
+    }
+    xStreamBufferSend(jitter_buffer, samples, payload, 0);
+}
+
+static void udp_rx_task(void *arg)
+{
+    bool have_seq = false;
+    uint32_t expected_seq = 0;
+    bool rate_warned = false;
+
+    while (running) {
+        int len = recv(sock, packet, sizeof(packet), 0);
+        if (len > 0) {
+            handle_packet((size_t)len, &have_seq, &expected_seq, &rate_warned);
+        }
+    }
+
+    rx_task = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t udp_pcm_init(uint32_t sample_rate_hz)
+{
+    if (sock >= 0) {
+        ESP_LOGW(TAG, "UDP PCM source already running");
+        return ESP_OK;
+    }
+    if (sample_rate_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t buffer_bytes = (size_t)sample_rate_hz * CONFIG_AUDIO_UDP_BUFFER_MS / 1000 * sizeof(int16_t);
+    jitter_buffer = xStreamBufferCreate(buffer_bytes, sizeof(int16_t));
+    if (jitter_buffer == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Failed to create socket: errno %d", errno);
+        vStreamBufferDelete(jitter_buffer);
+        jitter_buffer = NULL;
+        return ESP_FAIL;
+    }
+
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(CONFIG_AUDIO_UDP_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    struct timeval poll = { .tv_sec = 0, .tv_usec = RX_POLL_MS * 1000 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &poll, sizeof(poll));
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        ESP_LOGE(TAG, "Failed to bind UDP port %d: errno %d", CONFIG_AUDIO_UDP_PORT, errno);
+        close(sock);
+        sock = -1;
+        vStreamBufferDelete(jitter_buffer);
+        jitter_buffer = NULL;
+        return ESP_FAIL;
+    }
+
+    stream_rate_hz = sample_rate_hz;
+    running = true;
+    if (xTaskCreate(udp_rx_task, "udp_pcm_rx", RX_TASK_STACK, NULL, RX_TASK_PRIORITY, &rx_task) != pdPASS) {
+        running = false;
+        close(sock);
+        sock = -1;
+        vStreamBufferDelete(jitter_buffer);
+        jitter_buffer = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Listening for %lu Hz PCM on UDP port %d (%d ms buffer)", (unsigned long)sample_rate_hz,
+             CONFIG_AUDIO_UDP_PORT, CONFIG_AUDIO_UDP_BUFFER_MS);
+    return ESP_OK;
+}
+
+esp_err_t udp_pcm_read_frame(int16_t *out, size_t len, uint32_t timeout_ms)
+{
+    if (jitter_buffer == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    size_t filled = 0;
+    size_t total = len * sizeof(int16_t);
+
+    while (filled < total) {
+        int64_t remaining_us = deadline - esp_timer_get_time();
+        if (remaining_us <= 0) {
+            underrun_count++;
+            return ESP_ERR_TIMEOUT;
+        }
+        filled += xStreamBufferReceive(jitter_buffer, (uint8_t *)out + filled, total - filled,
+                                       pdMS_TO_TICKS(remaining_us / 1000) + 1);
+    }
+
+    frame_count++;
+    return ESP_OK;
+}
+
+esp_err_t udp_pcm_flush(void)
+{
+    if (jitter_buffer == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return xStreamBufferReset(jitter_buffer) == pdPASS ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+void udp_pcm_get_stats(audio_source_stats_t *out)
+{
+    out->frames = frame_count;
+    out->overruns = overrun_count;
+    out->underruns = underrun_count;
+    out->lost = lost_count;
+    out->hw_rate_hz = stream_rate_hz;
+}
+
+esp_err_t udp_pcm_deinit(void)
+{
+    if (sock < 0) {
+        return ESP_OK;
+    }
+
+    // The receive task notices within one socket timeout
+    running = false;
+    while (rx_task != NULL) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    close(sock);
+    sock = -1;
+    vStreamBufferDelete(jitter_buffer);
+    jitter_buffer = NULL;
+    return ESP_OK;
+}
+
+const audio_source_t udp_audio_source = {
+    .name = "udp",
+    .open = udp_pcm_init,
+    .read_frame = udp_pcm_read_frame,
+    .flush = udp_pcm_flush,
+    .close = udp_pcm_deinit,
+    .get_stats = udp_pcm_get_stats,
+};
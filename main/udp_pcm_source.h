@@ -0,0 +1,62 @@
+#pragma once
+
+#include <esp_err.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "audio_source.h"
+
+// Wire format: one header, then mono signed 16-bit little-endian samples at
+// the analysis rate. A packet carries at most UDP_PCM_MAX_SAMPLES samples so
+// it fits one Ethernet frame. host/send_pcm.py is a reference sender.
+#define UDP_PCM_MAGIC 0x4D435053u  // "SPCM" read as little-endian
+#define UDP_PCM_MAX_SAMPLES 640
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;           // UDP_PCM_MAGIC
+    uint32_t seq;             // Increments by one per packet; gaps are counted as lost
+    uint32_t sample_rate_hz;  // Must equal SAMPLE_RATE, other packets are dropped
+} udp_pcm_header_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start receiving PCM packets on CONFIG_AUDIO_UDP_PORT
+ *
+ * A receive task copies each packet's samples into a jitter buffer of
+ * CONFIG_AUDIO_UDP_BUFFER_MS, so the analysis sees the same blocking
+ * read_frame() as with a local microphone. Needs the network stack up.
+ *
+ * @param sample_rate_hz Rate the sender must stream at
+ * @return esp_err_t ESP_OK on success, otherwise error
+ */
+esp_err_t udp_pcm_init(uint32_t sample_rate_hz);
+
+/**
+ * @brief Block until len samples have arrived and copy them out
+ *
+ * Samples are scaled from 16-bit full scale to a 12-bit swing.
+ *
+ * @return esp_err_t ESP_OK on success, ESP_ERR_TIMEOUT if the stream stalled
+ */
+esp_err_t udp_pcm_read_frame(int16_t *out, size_t len, uint32_t timeout_ms);
+
+/**
+ * @brief Drop everything in the jitter buffer
+ */
+esp_err_t udp_pcm_flush(void);
+
+void udp_pcm_get_stats(audio_source_stats_t *out);
+
+/**
+ * @brief Stop the receive task and close the socket
+ */
+esp_err_t udp_pcm_deinit(void);
+
+// PCM over UDP as an analysis audio source
+extern const audio_source_t udp_audio_source;
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,5 +1,12 @@
 #include "web_server.h"
 #include "led_strip_control.h"
+#include "FFT.h"
+#include "beat_detector.h"
+#include "goertzel.h"
+#include "agc.h"
+#include "audio_pipeline.h"
+#include "freq_color_mapper.h"
+#include "led_effects.h"
 #include <esp_log.h>
 #include <esp_http_server.h>
 #include <cJSON.h>
@@ -59,6 +66,47 @@ static esp_err_t get_status_handler(httpd_req_t *req) {
     cJSON_AddNumberToObject(root, "brightness", led_strip_get_brightness());
     cJSON_AddNumberToObject(root, "hue", led_strip_get_hue());
     cJSON_AddNumberToObject(root, "saturation", led_strip_get_saturation());
+    uint8_t wb_r, wb_g, wb_b;
+    led_strip_get_white_balance(&wb_r, &wb_g, &wb_b);
+    cJSON *white_balance = cJSON_AddObjectToObject(root, "white_balance");
+    cJSON_AddNumberToObject(white_balance, "r", wb_r);
+    cJSON_AddNumberToObject(white_balance, "g", wb_g);
+    cJSON_AddNumberToObject(white_balance, "b", wb_b);
+    uint32_t attack_ms, release_ms;
+    led_strip_get_smoothing(&attack_ms, &release_ms);
+    cJSON *smoothing = cJSON_AddObjectToObject(root, "smoothing");
+    cJSON_AddNumberToObject(smoothing, "attack_ms", attack_ms);
+    cJSON_AddNumberToObject(smoothing, "release_ms", release_ms);
+    led_output_stats_t output_stats;
+    led_strip_get_output_stats(&output_stats);
+    cJSON *output = cJSON_AddObjectToObject(root, "output");
+    cJSON_AddBoolToObject(output, "dither", led_strip_get_dither());
+    cJSON_AddNumberToObject(output, "dither_hold_ms", led_strip_get_dither_hold());
+    cJSON_AddBoolToObject(output, "refreshing", output_stats.refreshing);
+    cJSON_AddBoolToObject(output, "dithering", output_stats.dithering);
+    cJSON_AddNumberToObject(output, "frames", output_stats.frames);
+    cJSON_AddNumberToObject(output, "frame_us_avg", output_stats.frame_us_avg);
+    cJSON_AddNumberToObject(output, "frame_us_p99", output_stats.frame_us_p99);
+    cJSON_AddNumberToObject(output, "frame_us_max", output_stats.frame_us_max);
+    cJSON_AddNumberToObject(output, "busy_waits", output_stats.busy_waits);
+    cJSON_AddNumberToObject(output, "leds", led_strip_get_led_count());
+    led_output_config_t strips[LED_MAX_OUTPUTS];
+    int strip_count = led_strip_get_outputs(strips, LED_MAX_OUTPUTS);
+    cJSON *strip_array = cJSON_AddArrayToObject(output, "strips");
+    for (int i = 0; i < strip_count && i < LED_MAX_OUTPUTS; i++) {
+        cJSON *strip = cJSON_CreateObject();
+        cJSON_AddNumberToObject(strip, "gpio", strips[i].gpio_num);
+        cJSON_AddNumberToObject(strip, "leds", strips[i].led_count);
+        cJSON_AddStringToObject(strip, "order", led_color_order_name(strips[i].order));
+        cJSON_AddItemToArray(strip_array, strip);
+    }
+    cJSON *render = cJSON_AddObjectToObject(root, "render");
+    cJSON_AddNumberToObject(render, "frame_rate_hz", output_stats.frame_rate_hz);
+    cJSON_AddBoolToObject(render, "running", output_stats.clock_running);
+    cJSON_AddNumberToObject(render, "dropped_frames", output_stats.dropped_frames);
+    cJSON_AddNumberToObject(render, "render_us_avg", output_stats.render_us_avg);
+    cJSON_AddNumberToObject(render, "render_us_p99", output_stats.render_us_p99);
+    cJSON_AddNumberToObject(render, "render_us_max", output_stats.render_us_max);
     // cJSON_AddBoolToObject(root, "adaptive_mode", led_strip_get_adaptive_mode()); // Removed
 
     // Add current mode string
@@ -67,6 +115,7 @@ static esp_err_t get_status_handler(httpd_req_t *req) {
     switch (current_mode) {
         case MODE_ADAPTIVE: mode_str = "adaptive"; break;
         case MODE_ENVIRONMENTAL: mode_str = "environmental"; break;
+        case MODE_EFFECT: mode_str = "effect"; break;
         case MODE_MANUAL:
         default: mode_str = "manual"; break;
     }
@@ -179,16 +228,15 @@ static esp_err_t set_color_handler(httpd_req_t *req) {
     
     cJSON_Delete(root);
     
-    // Set the hue and saturation
+    // Set the hue and saturation as one change
+    led_strip_begin();
     esp_err_t err = led_strip_set_hue((uint16_t)hue);
-    if (err != ESP_OK) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to set hue");
-        return ESP_FAIL;
+    if (err == ESP_OK) {
+        err = led_strip_set_saturation((uint8_t)saturation);
     }
-    
-    err = led_strip_set_saturation((uint8_t)saturation);
+    led_strip_commit();
     if (err != ESP_OK) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to set saturation");
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to set color");
         return ESP_FAIL;
     }
     
@@ -227,9 +275,11 @@ static esp_err_t set_mode_handler(httpd_req_t *req) {
         new_mode = MODE_ADAPTIVE;
     } else if (strcmp(mode_str, "environmental") == 0) {
         new_mode = MODE_ENVIRONMENTAL;
+    } else if (strcmp(mode_str, "effect") == 0) {
+        new_mode = MODE_EFFECT;
     } else {
         cJSON_Delete(root);
-        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid mode value. Use 'manual', 'adaptive', or 'environmental'.");
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid mode value. Use 'manual', 'adaptive', 'environmental' or 'effect'.");
         return ESP_FAIL;
     }
 
@@ -249,6 +299,7 @@ static esp_err_t set_mode_handler(httpd_req_t *req) {
     switch (current_mode) {
         case MODE_ADAPTIVE: mode_str = "adaptive"; break;
         case MODE_ENVIRONMENTAL: mode_str = "environmental"; break;
+        case MODE_EFFECT: mode_str = "effect"; break;
         case MODE_MANUAL:
         default: mode_str = "manual"; break;
     }
@@ -257,6 +308,599 @@ static esp_err_t set_mode_handler(httpd_req_t *req) {
     return send_json_response(req, root);
 }
 
+// API endpoint to set the per-install white balance: {"r": 255, "g": 230, "b": 200}
+static esp_err_t set_white_balance_handler(httpd_req_t *req) {
+    ESP_LOGI(TAG, "POST /api/white_balance");
+
+    cJSON *root = parse_json_request(req);
+    if (!root) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
+        return ESP_FAIL;
+    }
+
+    static const char *channels[3] = {"r", "g", "b"};
+    int value[3];
+    for (int i = 0; i < 3; i++) {
+        cJSON *item = cJSON_GetObjectItem(root, channels[i]);
+        if (!cJSON_IsNumber(item) || item->valueint < 0 || item->valueint > 255) {
+            cJSON_Delete(root);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "'r', 'g' and 'b' must be between 0-255");
+            return ESP_FAIL;
+        }
+        value[i] = item->valueint;
+    }
+    cJSON_Delete(root);
+
+    esp_err_t err = led_strip_set_white_balance((uint8_t)value[0], (uint8_t)value[1], (uint8_t)value[2]);
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to set white balance");
+        return ESP_FAIL;
+    }
+
+    root = cJSON_CreateObject();
+    cJSON_AddBoolToObject(root, "success", true);
+
+    return send_json_response(req, root);
+}
+
+// API endpoint to set per-LED smoothing: {"attack_ms": 20, "release_ms": 150}, either optional
+static esp_err_t set_smoothing_handler(httpd_req_t *req) {
+    ESP_LOGI(TAG, "POST /api/smoothing");
+
+    cJSON *root = parse_json_request(req);
+    if (!root) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
+        return ESP_FAIL;
+    }
+
+    cJSON *attack_json = cJSON_GetObjectItem(root, "attack_ms");
+    cJSON *release_json = cJSON_GetObjectItem(root, "release_ms");
+    if (!cJSON_IsNumber(attack_json) && !cJSON_IsNumber(release_json)) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing 'attack_ms' or 'release_ms' field");
+        return ESP_FAIL;
+    }
+
+    uint32_t attack_ms, release_ms;
+    led_strip_get_smoothing(&attack_ms, &release_ms);
+    bool valid = true;
+    if (cJSON_IsNumber(attack_json)) {
+        valid = valid && attack_json->valueint >= 0;
+        attack_ms = (uint32_t)attack_json->valueint;
+    }
+    if (cJSON_IsNumber(release_json)) {
+        valid = valid && release_json->valueint >= 0;
+        release_ms = (uint32_t)release_json->valueint;
+    }
+    cJSON_Delete(root);
+
+    if (!valid || led_strip_set_smoothing(attack_ms, release_ms) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Attack and release must be between 0-10000 ms");
+        return ESP_FAIL;
+    }
+
+    root = cJSON_CreateObject();
+    cJSON_AddBoolToObject(root, "success", true);
+    cJSON_AddNumberToObject(root, "attack_ms", attack_ms);
+    cJSON_AddNumberToObject(root, "release_ms", release_ms);
+
+    return send_json_response(req, root);
+}
+
+// API endpoint to configure temporal dithering: {"enabled": true, "hold_ms": 0}, either optional
+static esp_err_t set_dither_handler(httpd_req_t *req) {
+    ESP_LOGI(TAG, "POST /api/dither");
+
+    cJSON *root = parse_json_request(req);
+    if (!root) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
+        return ESP_FAIL;
+    }
+
+    cJSON *enabled_json = cJSON_GetObjectItem(root, "enabled");
+    cJSON *hold_json = cJSON_GetObjectItem(root, "hold_ms");
+    if (!cJSON_IsBool(enabled_json) && !cJSON_IsNumber(hold_json)) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing 'enabled' or 'hold_ms' field");
+        return ESP_FAIL;
+    }
+    if (cJSON_IsNumber(hold_json) &&
+        (hold_json->valueint < 0 || hold_json->valueint > LED_DITHER_HOLD_MAX_MS)) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Hold must be between 0-10000 ms");
+        return ESP_FAIL;
+    }
+    if (cJSON_IsNumber(hold_json)) {
+        led_strip_set_dither_hold((uint32_t)hold_json->valueint);
+    }
+    if (cJSON_IsBool(enabled_json)) {
+        led_strip_set_dither(cJSON_IsTrue(enabled_json));
+    }
+    cJSON_Delete(root);
+
+    root = cJSON_CreateObject();
+    cJSON_AddBoolToObject(root, "success", true);
+    cJSON_AddBoolToObject(root, "enabled", led_strip_get_dither());
+    cJSON_AddNumberToObject(root, "hold_ms", led_strip_get_dither_hold());
+
+    return send_json_response(req, root);
+}
+
+static void add_stage_stats(cJSON *parent, const char *name, const audio_stage_stats_t *s) {
+    cJSON *stage = cJSON_AddObjectToObject(parent, name);
+    cJSON_AddNumberToObject(stage, "last", s->last_us);
+    cJSON_AddNumberToObject(stage, "min", s->min_us);
+    cJSON_AddNumberToObject(stage, "avg", s->avg_us);
+    cJSON_AddNumberToObject(stage, "p99", s->p99_us);
+    cJSON_AddNumberToObject(stage, "max", s->max_us);
+}
+
+// API endpoint to read the latest audio analysis frame
+static esp_err_t get_audio_handler(httpd_req_t *req) {
+    ESP_LOGD(TAG, "GET /api/audio");
+
+    audio_frame_t frame;
+    bool valid = fft_get_latest_frame(&frame);
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddBoolToObject(root, "valid", valid);
+    cJSON_AddNumberToObject(root, "frame", frame.seq);
+    cJSON_AddNumberToObject(root, "frame_rate", fft_get_frame_rate());
+    cJSON_AddNumberToObject(root, "dominant_freq", frame.dominant_freq);
+    cJSON_AddNumberToObject(root, "magnitude", frame.dominant_magnitude);
+    cJSON_AddNumberToObject(root, "bpm", frame.bpm);
+    cJSON_AddNumberToObject(root, "bpm_confidence", beat_detector_get_confidence());
+
+    fft_analyzer_t analyzer = fft_get_analyzer();
+    cJSON_AddStringToObject(root, "analyzer", analyzer == FFT_ANALYZER_GOERTZEL ? "goertzel" : "fft");
+    cJSON_AddNumberToObject(root, "cycles_per_sample", fft_get_analyzer_cost(analyzer));
+
+    uint32_t attack_ms, release_ms;
+    agc_get_times(&attack_ms, &release_ms);
+    cJSON *agc = cJSON_AddObjectToObject(root, "agc");
+    cJSON_AddBoolToObject(agc, "enabled", agc_is_enabled());
+    cJSON_AddNumberToObject(agc, "attack_ms", attack_ms);
+    cJSON_AddNumberToObject(agc, "release_ms", release_ms);
+    cJSON_AddNumberToObject(agc, "level", agc_get_level());
+
+    const audio_source_t *source = fft_get_source();
+    if (source) {
+        cJSON *src = cJSON_AddObjectToObject(root, "source");
+        cJSON_AddStringToObject(src, "name", source->name);
+        cJSON_AddNumberToObject(src, "sample_rate", SAMPLE_RATE);
+        if (source->get_stats) {
+            audio_source_stats_t src_stats;
+            source->get_stats(&src_stats);
+            cJSON_AddNumberToObject(src, "overruns", src_stats.overruns);
+            cJSON_AddNumberToObject(src, "underruns", src_stats.underruns);
+            cJSON_AddNumberToObject(src, "lost", src_stats.lost);
+        }
+    }
+
+    audio_latency_t stats;
+    audio_pipeline_get_latency(&stats);
+    cJSON *latency = cJSON_AddObjectToObject(root, "latency_us");
+    for (int i = 0; i < AUDIO_STAGE_COUNT; i++) {
+        add_stage_stats(latency, audio_pipeline_stage_name((audio_stage_t)i), &stats.stage[i]);
+    }
+    cJSON_AddNumberToObject(root, "frames_dropped", stats.dropped);
+    cJSON_AddNumberToObject(root, "frames_skipped", stats.skipped);
+
+    audio_jitter_t jitter;
+    audio_pipeline_get_jitter(&jitter);
+    cJSON *jitter_json = cJSON_AddObjectToObject(root, "jitter");
+    add_stage_stats(jitter_json, "lateness_us", &jitter.late);
+    cJSON_AddNumberToObject(jitter_json, "frames", jitter.frames);
+    cJSON_AddNumberToObject(jitter_json, "late_frames", jitter.late_frames);
+    cJSON *hist = cJSON_AddArrayToObject(jitter_json, "histogram");
+    for (int i = 0; i < AUDIO_LATENESS_BUCKETS; i++) {
+        cJSON *bucket = cJSON_CreateObject();
+        uint32_t bound = audio_pipeline_lateness_bucket_us(i);
+        if (bound) {
+            cJSON_AddNumberToObject(bucket, "below_us", bound);
+        }
+        cJSON_AddNumberToObject(bucket, "samples", jitter.samples[i]);
+        cJSON_AddItemToArray(hist, bucket);
+    }
+
+    cJSON *bands = cJSON_AddArrayToObject(root, "bands");
+    cJSON *centers = cJSON_AddArrayToObject(root, "band_centers");
+    for (int i = 0; valid && i < frame.band_count; i++) {
+        float center = (analyzer == FFT_ANALYZER_GOERTZEL) ? goertzel_bank_get_frequency(i)
+                                                           : filterbank_get_band_center(i);
+        cJSON_AddItemToArray(bands, cJSON_CreateNumber(frame.bands[i]));
+        cJSON_AddItemToArray(centers, cJSON_CreateNumber(center));
+    }
+
+    return send_json_response(req, root);
+}
+
+// API endpoint to configure audio analysis
+static esp_err_t set_audio_handler(httpd_req_t *req) {
+    ESP_LOGI(TAG, "POST /api/audio");
+
+    cJSON *root = parse_json_request(req);
+    if (!root) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
+        return ESP_FAIL;
+    }
+
+    cJSON *bands_json = cJSON_GetObjectItem(root, "bands");
+    cJSON *analyzer_json = cJSON_GetObjectItem(root, "analyzer");
+    cJSON *freqs_json = cJSON_GetObjectItem(root, "goertzel_freqs");
+    cJSON *agc_json = cJSON_GetObjectItem(root, "agc");
+    if (!cJSON_IsNumber(bands_json) && !cJSON_IsString(analyzer_json) && !cJSON_IsArray(freqs_json) &&
+        !cJSON_IsObject(agc_json)) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing 'bands', 'analyzer', 'goertzel_freqs' or 'agc' field");
+        return ESP_FAIL;
+    }
+
+    // Every field is validated before any is applied, so a bad request changes nothing.
+    // AGC settings: {"enabled": bool, "attack_ms": n, "release_ms": n}, all optional
+    uint32_t attack_ms, release_ms;
+    agc_get_times(&attack_ms, &release_ms);
+    bool agc_enabled = agc_is_enabled();
+    if (cJSON_IsObject(agc_json)) {
+        cJSON *enabled_json = cJSON_GetObjectItem(agc_json, "enabled");
+        cJSON *attack_json = cJSON_GetObjectItem(agc_json, "attack_ms");
+        cJSON *release_json = cJSON_GetObjectItem(agc_json, "release_ms");
+        if (cJSON_IsBool(enabled_json)) {
+            agc_enabled = cJSON_IsTrue(enabled_json);
+        }
+        if (cJSON_IsNumber(attack_json)) {
+            attack_ms = attack_json->valueint > 0 ? (uint32_t)attack_json->valueint : 0;
+        }
+        if (cJSON_IsNumber(release_json)) {
+            release_ms = release_json->valueint > 0 ? (uint32_t)release_json->valueint : 0;
+        }
+        if (attack_ms == 0 || release_ms == 0 || attack_ms > release_ms) {
+            cJSON_Delete(root);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "AGC attack and release must be > 0 ms, attack <= release");
+            return ESP_FAIL;
+        }
+    }
+
+    fft_analyzer_t analyzer = fft_get_analyzer();
+    if (cJSON_IsString(analyzer_json)) {
+        const char *name = analyzer_json->valuestring;
+        if (strcmp(name, "fft") == 0) {
+            analyzer = FFT_ANALYZER_FFT;
+        } else if (strcmp(name, "goertzel") == 0) {
+            analyzer = FFT_ANALYZER_GOERTZEL;
+        } else {
+            cJSON_Delete(root);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Analyzer must be 'fft' or 'goertzel'");
+            return ESP_FAIL;
+        }
+    }
+
+    int bands = 0;
+    if (cJSON_IsNumber(bands_json)) {
+        bands = bands_json->valueint;
+        if (bands < 1 || bands > FILTERBANK_MAX_BANDS) {
+            cJSON_Delete(root);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Band count must be between 1-32");
+            return ESP_FAIL;
+        }
+    }
+
+    float freqs[GOERTZEL_MAX_FILTERS];
+    int freq_count = 0;
+    if (cJSON_IsArray(freqs_json)) {
+        freq_count = cJSON_GetArraySize(freqs_json);
+        bool ok = freq_count >= 1 && freq_count <= GOERTZEL_MAX_FILTERS;
+        for (int i = 0; ok && i < freq_count; i++) {
+            cJSON *item = cJSON_GetArrayItem(freqs_json, i);
+            ok = cJSON_IsNumber(item) && item->valuedouble > 0.0 && item->valuedouble < SAMPLE_RATE / 2.0;
+            if (ok) {
+                freqs[i] = (float)item->valuedouble;
+            }
+        }
+        if (!ok) {
+            cJSON_Delete(root);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "goertzel_freqs must be 1-16 frequencies below Nyquist");
+            return ESP_FAIL;
+        }
+    }
+
+    // Everything is valid; apply it all, so a bad request changes nothing
+    if (bands > 0) {
+        fft_set_band_count((uint8_t)bands);
+    }
+    if (freq_count > 0) {
+        fft_set_goertzel_freqs(freqs, (uint8_t)freq_count);
+    }
+    fft_set_analyzer(analyzer);
+    agc_set_times(attack_ms, release_ms);
+    agc_set_enabled(agc_enabled);
+    cJSON_Delete(root);
+
+    // Return success response
+    root = cJSON_CreateObject();
+    cJSON_AddBoolToObject(root, "success", true);
+    cJSON_AddNumberToObject(root, "bands", fft_get_band_count());
+    cJSON_AddStringToObject(root, "analyzer", fft_get_analyzer() == FFT_ANALYZER_GOERTZEL ? "goertzel" : "fft");
+
+    return send_json_response(req, root);
+}
+
+// API endpoint to list the colour palettes used by adaptive mode
+static esp_err_t get_palette_handler(httpd_req_t *req) {
+    ESP_LOGI(TAG, "GET /api/palette");
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "active", palette_name(palette_get_active()));
+    cJSON *names = cJSON_AddArrayToObject(root, "palettes");
+    for (int i = 0; i < palette_count(); i++) {
+        cJSON_AddItemToArray(names, cJSON_CreateString(palette_name(i)));
+    }
+    float min_hz, max_hz;
+    palette_get_range(&min_hz, &max_hz);
+    cJSON_AddNumberToObject(root, "min_hz", min_hz);
+    cJSON_AddNumberToObject(root, "max_hz", max_hz);
+
+    return send_json_response(req, root);
+}
+
+// Parse [[pos, r, g, b], ...] into stops; false if malformed
+static bool parse_palette_stops(cJSON *stops_json, palette_stop_t *stops, int *count) {
+    *count = cJSON_GetArraySize(stops_json);
+    if (*count < 1 || *count > PALETTE_MAX_STOPS) {
+        return false;
+    }
+    for (int i = 0; i < *count; i++) {
+        cJSON *stop = cJSON_GetArrayItem(stops_json, i);
+        if (!cJSON_IsArray(stop) || cJSON_GetArraySize(stop) != 4) {
+            return false;
+        }
+        int v[4];
+        for (int j = 0; j < 4; j++) {
+            cJSON *item = cJSON_GetArrayItem(stop, j);
+            if (!cJSON_IsNumber(item) || item->valueint < 0 || item->valueint > 255) {
+                return false;
+            }
+            v[j] = item->valueint;
+        }
+        stops[i] = palette_stop_t{(uint8_t)v[0], {(uint8_t)v[1], (uint8_t)v[2], (uint8_t)v[3]}};
+    }
+    return true;
+}
+
+// API endpoint to switch, upload or re-range palettes:
+// {"name": "fire"}, {"name": "mine", "stops": [[0, 255, 0, 0], [255, 0, 0, 255]]},
+// {"min_hz": 40, "max_hz": 4000}
+static esp_err_t set_palette_handler(httpd_req_t *req) {
+    ESP_LOGI(TAG, "POST /api/palette");
+
+    cJSON *root = parse_json_request(req);
+    if (!root) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
+        return ESP_FAIL;
+    }
+
+    cJSON *name_json = cJSON_GetObjectItem(root, "name");
+    cJSON *stops_json = cJSON_GetObjectItem(root, "stops");
+    cJSON *min_json = cJSON_GetObjectItem(root, "min_hz");
+    cJSON *max_json = cJSON_GetObjectItem(root, "max_hz");
+    bool has_name = cJSON_IsString(name_json) && name_json->valuestring != NULL;
+    if (!has_name && !cJSON_IsNumber(min_json) && !cJSON_IsNumber(max_json)) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing 'name', 'min_hz' or 'max_hz' field");
+        return ESP_FAIL;
+    }
+
+    // The range and name are checked before anything changes; an upload is
+    // the only step that can still fail, and it goes first
+    bool has_range = cJSON_IsNumber(min_json) || cJSON_IsNumber(max_json);
+    float min_hz, max_hz;
+    palette_get_range(&min_hz, &max_hz);
+    if (cJSON_IsNumber(min_json)) {
+        min_hz = (float)min_json->valuedouble;
+    }
+    if (cJSON_IsNumber(max_json)) {
+        max_hz = (float)max_json->valuedouble;
+    }
+    if (has_range && !palette_range_valid(min_hz, max_hz)) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Range must be at least an octave, from 1 Hz");
+        return ESP_FAIL;
+    }
+
+    int index = -1;
+    if (has_name) {
+        if (cJSON_IsArray(stops_json)) {
+            palette_stop_t stops[PALETTE_MAX_STOPS];
+            int count;
+            index = parse_palette_stops(stops_json, stops, &count)
+                        ? palette_upload(name_json->valuestring, stops, count) : -1;
+            if (index < 0) {
+                cJSON_Delete(root);
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                                    "Stops must be 1-16 [pos, r, g, b] in increasing pos order, under a new "
+                                    "or uploaded name; at most 4 uploaded palettes");
+                return ESP_FAIL;
+            }
+        } else {
+            index = palette_find(name_json->valuestring);
+            if (index < 0) {
+                cJSON_Delete(root);
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown palette");
+                return ESP_FAIL;
+            }
+        }
+    }
+    cJSON_Delete(root);
+
+    if (has_range) {
+        palette_set_range(min_hz, max_hz);
+    }
+    if (has_name) {
+        palette_select(index);
+    }
+
+    root = cJSON_CreateObject();
+    cJSON_AddBoolToObject(root, "success", true);
+    cJSON_AddStringToObject(root, "active", palette_name(palette_get_active()));
+
+    return send_json_response(req, root);
+}
+
+static cJSON *create_rgb_array(rgb_t c) {
+    cJSON *array = cJSON_CreateArray();
+    cJSON_AddItemToArray(array, cJSON_CreateNumber(c.r));
+    cJSON_AddItemToArray(array, cJSON_CreateNumber(c.g));
+    cJSON_AddItemToArray(array, cJSON_CreateNumber(c.b));
+    return array;
+}
+
+// Render cost in µs per 100 LEDs, and the longest strip the effect alone fills at 100 fps
+static void add_effect_cost(cJSON *parent, const led_effect_cost_t *cost) {
+    cJSON *obj = cJSON_AddObjectToObject(parent, "cost");
+    cJSON_AddNumberToObject(obj, "frames", cost->frames);
+    cJSON_AddNumberToObject(obj, "us_per_100_avg", cost->ns_per_100_avg / 1000.0);
+    cJSON_AddNumberToObject(obj, "us_per_100_p99", cost->ns_per_100_p99 / 1000.0);
+    cJSON_AddNumberToObject(obj, "us_per_100_max", cost->ns_per_100_max / 1000.0);
+    if (cost->ns_per_100_avg > 0) {
+        cJSON_AddNumberToObject(obj, "max_leds_100fps", (uint32_t)(10000ull * 100000 / cost->ns_per_100_avg));
+    }
+}
+
+// API endpoint to list the effects with their parameters and measured cost
+static esp_err_t get_effect_handler(httpd_req_t *req) {
+    ESP_LOGI(TAG, "GET /api/effect");
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "active", led_effect_name(led_effect_get_active()));
+    cJSON *effects = cJSON_AddArrayToObject(root, "effects");
+    for (int i = 0; i < EFFECT_COUNT; i++) {
+        led_effect_params_t params;
+        led_effect_cost_t cost;
+        led_effect_get_params(i, &params);
+        led_effect_get_cost(i, &cost);
+        cJSON *effect = cJSON_CreateObject();
+        cJSON_AddStringToObject(effect, "name", led_effect_name(i));
+        cJSON_AddNumberToObject(effect, "speed", params.speed);
+        cJSON_AddNumberToObject(effect, "size", params.size);
+        cJSON_AddNumberToObject(effect, "intensity", params.intensity);
+        cJSON_AddItemToObject(effect, "color1", create_rgb_array(params.color1));
+        cJSON_AddItemToObject(effect, "color2", create_rgb_array(params.color2));
+        add_effect_cost(effect, &cost);
+        cJSON_AddItemToArray(effects, effect);
+    }
+
+    return send_json_response(req, root);
+}
+
+// Parse [r, g, b]; false if malformed
+static bool parse_rgb_array(cJSON *array, rgb_t *out) {
+    if (!cJSON_IsArray(array) || cJSON_GetArraySize(array) != 3) {
+        return false;
+    }
+    uint8_t v[3];
+    for (int i = 0; i < 3; i++) {
+        cJSON *item = cJSON_GetArrayItem(array, i);
+        if (!cJSON_IsNumber(item) || item->valueint < 0 || item->valueint > 255) {
+            return false;
+        }
+        v[i] = (uint8_t)item->valueint;
+    }
+    *out = rgb_t{v[0], v[1], v[2]};
+    return true;
+}
+
+// API endpoint to show an effect and tune it, or to benchmark every effect:
+// {"name": "fire", "speed": 128, "size": 55, "intensity": 120}, {"color1": [255, 0, 0]},
+// {"bench": 300} (LEDs; answers with each effect's cost on a scratch buffer)
+static esp_err_t set_effect_handler(httpd_req_t *req) {
+    ESP_LOGI(TAG, "POST /api/effect");
+
+    cJSON *root = parse_json_request(req);
+    if (!root) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
+        return ESP_FAIL;
+    }
+
+    cJSON *bench_json = cJSON_GetObjectItem(root, "bench");
+    if (cJSON_IsNumber(bench_json)) {
+        int leds = bench_json->valueint;
+        cJSON_Delete(root);
+        led_effect_cost_t costs[EFFECT_COUNT];
+        if (leds < 1 || leds > 4096 || led_effects_benchmark((uint16_t)leds, 200, costs) != ESP_OK) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Benchmark needs 1-4096 LEDs and the memory for them");
+            return ESP_FAIL;
+        }
+        root = cJSON_CreateObject();
+        cJSON_AddNumberToObject(root, "leds", leds);
+        cJSON *effects = cJSON_AddArrayToObject(root, "effects");
+        for (int i = 0; i < EFFECT_COUNT; i++) {
+            cJSON *effect = cJSON_CreateObject();
+            cJSON_AddStringToObject(effect, "name", led_effect_name(i));
+            add_effect_cost(effect, &costs[i]);
+            cJSON_AddItemToArray(effects, effect);
+        }
+        return send_json_response(req, root);
+    }
+
+    cJSON *name_json = cJSON_GetObjectItem(root, "name");
+    int effect = led_effect_get_active();
+    if (cJSON_IsString(name_json) && name_json->valuestring != NULL) {
+        effect = led_effect_find(name_json->valuestring);
+        if (effect < 0) {
+            cJSON_Delete(root);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown effect");
+            return ESP_FAIL;
+        }
+    }
+
+    led_effect_params_t params;
+    led_effect_get_params(effect, &params);
+    static const char *fields[3] = {"speed", "size", "intensity"};
+    uint8_t *values[3] = {&params.speed, &params.size, &params.intensity};
+    for (int i = 0; i < 3; i++) {
+        cJSON *item = cJSON_GetObjectItem(root, fields[i]);
+        if (item == NULL) {
+            continue;
+        }
+        if (!cJSON_IsNumber(item) || item->valueint < 0 || item->valueint > 255) {
+            cJSON_Delete(root);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "'speed', 'size' and 'intensity' must be between 0-255");
+            return ESP_FAIL;
+        }
+        *values[i] = (uint8_t)item->valueint;
+    }
+    cJSON *color1_json = cJSON_GetObjectItem(root, "color1");
+    cJSON *color2_json = cJSON_GetObjectItem(root, "color2");
+    if ((color1_json && !parse_rgb_array(color1_json, &params.color1)) ||
+        (color2_json && !parse_rgb_array(color2_json, &params.color2))) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "'color1' and 'color2' must be [r, g, b] with 0-255 values");
+        return ESP_FAIL;
+    }
+    bool select = cJSON_IsString(name_json);
+    cJSON_Delete(root);
+
+    // Naming an effect shows it
+    led_strip_begin();
+    led_effect_set_params(effect, &params);
+    esp_err_t err = ESP_OK;
+    if (select) {
+        led_effect_select(effect);
+        err = led_strip_set_mode(MODE_EFFECT);
+    }
+    led_strip_commit();
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to set mode");
+        return ESP_FAIL;
+    }
+
+    root = cJSON_CreateObject();
+    cJSON_AddBoolToObject(root, "success", true);
+    cJSON_AddStringToObject(root, "active", led_effect_name(led_effect_get_active()));
+
+    return send_json_response(req, root);
+}
+
 // API endpoint for CORS preflight requests
 static esp_err_t options_handler(httpd_req_t *req) {
     ESP_LOGI(TAG, "OPTIONS %s", req->uri);
@@ -285,6 +929,7 @@ esp_err_t web_server_start(void) {
     
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.stack_size = 8192;
+    config.max_uri_handlers = 32; // Default of 8 is too small for the API plus CORS handlers
     
     ESP_LOGI(TAG, "Starting web server on port: '%d'", config.server_port);
     if (httpd_start(&server, &config) != ESP_OK) {
@@ -325,6 +970,30 @@ esp_err_t web_server_start(void) {
     };
     httpd_register_uri_handler(server, &color_uri);
 
+    httpd_uri_t white_balance_uri = {
+        .uri = "/api/white_balance",
+        .method = HTTP_POST,
+        .handler = set_white_balance_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &white_balance_uri);
+
+    httpd_uri_t smoothing_uri = {
+        .uri = "/api/smoothing",
+        .method = HTTP_POST,
+        .handler = set_smoothing_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &smoothing_uri);
+
+    httpd_uri_t dither_uri = {
+        .uri = "/api/dither",
+        .method = HTTP_POST,
+        .handler = set_dither_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &dither_uri);
+
     // Add new mode endpoint
     httpd_uri_t mode_uri = {
         .uri = "/api/mode",
@@ -334,6 +1003,54 @@ esp_err_t web_server_start(void) {
     };
     httpd_register_uri_handler(server, &mode_uri);
 
+    httpd_uri_t audio_get_uri = {
+        .uri = "/api/audio",
+        .method = HTTP_GET,
+        .handler = get_audio_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &audio_get_uri);
+
+    httpd_uri_t audio_set_uri = {
+        .uri = "/api/audio",
+        .method = HTTP_POST,
+        .handler = set_audio_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &audio_set_uri);
+
+    httpd_uri_t palette_get_uri = {
+        .uri = "/api/palette",
+        .method = HTTP_GET,
+        .handler = get_palette_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &palette_get_uri);
+
+    httpd_uri_t palette_set_uri = {
+        .uri = "/api/palette",
+        .method = HTTP_POST,
+        .handler = set_palette_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &palette_set_uri);
+
+    httpd_uri_t effect_get_uri = {
+        .uri = "/api/effect",
+        .method = HTTP_GET,
+        .handler = get_effect_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &effect_get_uri);
+
+    httpd_uri_t effect_set_uri = {
+        .uri = "/api/effect",
+        .method = HTTP_POST,
+        .handler = set_effect_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &effect_set_uri);
+
     // CORS options handler for each endpoint
     httpd_uri_t options_uri_status = {
         .uri = "/api/status",
@@ -367,6 +1084,30 @@ esp_err_t web_server_start(void) {
     };
     httpd_register_uri_handler(server, &options_uri_color);
 
+    httpd_uri_t options_uri_white_balance = {
+        .uri = "/api/white_balance",
+        .method = HTTP_OPTIONS,
+        .handler = options_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &options_uri_white_balance);
+
+    httpd_uri_t options_uri_smoothing = {
+        .uri = "/api/smoothing",
+        .method = HTTP_OPTIONS,
+        .handler = options_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &options_uri_smoothing);
+
+    httpd_uri_t options_uri_dither = {
+        .uri = "/api/dither",
+        .method = HTTP_OPTIONS,
+        .handler = options_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &options_uri_dither);
+
     // Add OPTIONS handler for mode endpoint
     httpd_uri_t options_uri_mode = {
         .uri = "/api/mode",
@@ -375,6 +1116,30 @@ esp_err_t web_server_start(void) {
         .user_ctx = NULL
     };
     httpd_register_uri_handler(server, &options_uri_mode);
+
+    httpd_uri_t options_uri_audio = {
+        .uri = "/api/audio",
+        .method = HTTP_OPTIONS,
+        .handler = options_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &options_uri_audio);
+
+    httpd_uri_t options_uri_palette = {
+        .uri = "/api/palette",
+        .method = HTTP_OPTIONS,
+        .handler = options_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &options_uri_palette);
+
+    httpd_uri_t options_uri_effect = {
+        .uri = "/api/effect",
+        .method = HTTP_OPTIONS,
+        .handler = options_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &options_uri_effect);
     
     ESP_LOGI(TAG, "Web server started successfully");
     return ESP_OK;
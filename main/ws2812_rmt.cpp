@@ -0,0 +1,269 @@
+#include "ws2812_rmt.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "driver/rmt_tx.h"
+#include "driver/rmt_encoder.h"
+#include "soc/soc_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+static const char *TAG = "ws2812_rmt";
+
+/*
+ * WS2812 bit timings at 10 MHz (0.1 us per tick): a 0 is 0.3 us high then
+ * 0.9 us low, a 1 is 0.9 us high then 0.3 us low. Each frame ends with a
+ * low reset code that latches it; 280 us covers the newer WS2812B parts,
+ * which need far more than the 50 us of the original datasheet.
+ */
+#define WS2812_RESOLUTION_HZ (10 * 1000 * 1000)
+#define WS2812_T0H_TICKS 3
+#define WS2812_T0L_TICKS 9
+#define WS2812_T1H_TICKS 9
+#define WS2812_T1L_TICKS 3
+#define WS2812_RESET_TICKS 2800
+
+// With DMA the channel streams from a larger symbol buffer in internal RAM;
+// without it the driver refills the channel's RMT memory from its interrupt.
+// Chips have fewer DMA-capable RMT channels than TX channels (the S3 has one),
+// so later strips fall back to interrupt refill.
+#define WS2812_DMA_SYMBOLS 1024
+#define WS2812_MEM_SYMBOLS SOC_RMT_MEM_WORDS_PER_CHANNEL
+
+// Pixel bytes through a bytes encoder, then the reset code through a copy encoder
+struct ws2812_encoder {
+    rmt_encoder_t base;    // First, so the driver's rmt_encoder_t * is ours
+    rmt_encoder_t *bytes;
+    rmt_encoder_t *copy;
+    int state;             // 0 while sending pixels, 1 for the reset code
+    rmt_symbol_word_t reset_code;
+};
+
+struct ws2812_rmt {
+    rmt_channel_handle_t channel;
+    rmt_encoder_t *encoder;
+    uint8_t *buffers[2];
+    int back;                       // Index of the buffer being written
+    size_t frame_bytes;
+    SemaphoreHandle_t idle;         // Given when the last frame has gone out
+    std::atomic<uint32_t> busy_waits;
+};
+
+static size_t ws2812_encode(rmt_encoder_t *encoder, rmt_channel_handle_t channel, const void *data,
+                            size_t size, rmt_encode_state_t *ret_state)
+{
+    ws2812_encoder *enc = reinterpret_cast<ws2812_encoder *>(encoder);
+    rmt_encode_state_t session = RMT_ENCODING_RESET;
+    int state = RMT_ENCODING_RESET;
+    size_t written = 0;
+
+    if (enc->state == 0) {
+        written += enc->bytes->encode(enc->bytes, channel, data, size, &session);
+        if (session & RMT_ENCODING_COMPLETE) {
+            enc->state = 1;
+        }
+        if (session & RMT_ENCODING_MEM_FULL) {
+            *ret_state = (rmt_encode_state_t)(state | RMT_ENCODING_MEM_FULL);
+            return written;   // The driver calls again once there is room
+        }
+    }
+    written += enc->copy->encode(enc->copy, channel, &enc->reset_code, sizeof(enc->reset_code), &session);
+    if (session & RMT_ENCODING_COMPLETE) {
+        enc->state = 0;
+        state |= RMT_ENCODING_COMPLETE;
+    }
+    if (session & RMT_ENCODING_MEM_FULL) {
+        state |= RMT_ENCODING_MEM_FULL;
+    }
+    *ret_state = (rmt_encode_state_t)state;
+    return written;
+}
+
+static esp_err_t ws2812_encoder_reset(rmt_encoder_t *encoder)
+{
+    ws2812_encoder *enc = reinterpret_cast<ws2812_encoder *>(encoder);
+    rmt_encoder_reset(enc->bytes);
+    rmt_encoder_reset(enc->copy);
+    enc->state = 0;
+    return ESP_OK;
+}
+
+static esp_err_t ws2812_encoder_del(rmt_encoder_t *encoder)
+{
+    ws2812_encoder *enc = reinterpret_cast<ws2812_encoder *>(encoder);
+    rmt_del_encoder(enc->bytes);
+    rmt_del_encoder(enc->copy);
+    free(enc);
+    return ESP_OK;
+}
+
+static esp_err_t new_ws2812_encoder(rmt_encoder_t **out)
+{
+    ws2812_encoder *enc = (ws2812_encoder *)calloc(1, sizeof(ws2812_encoder));
+    if (!enc) {
+        return ESP_ERR_NO_MEM;
+    }
+    enc->base.encode = ws2812_encode;
+    enc->base.reset = ws2812_encoder_reset;
+    enc->base.del = ws2812_encoder_del;
+
+    rmt_bytes_encoder_config_t bytes_config = {};
+    bytes_config.bit0.level0 = 1;
+    bytes_config.bit0.duration0 = WS2812_T0H_TICKS;
+    bytes_config.bit0.level1 = 0;
+    bytes_config.bit0.duration1 = WS2812_T0L_TICKS;
+    bytes_config.bit1.level0 = 1;
+    bytes_config.bit1.duration0 = WS2812_T1H_TICKS;
+    bytes_config.bit1.level1 = 0;
+    bytes_config.bit1.duration1 = WS2812_T1L_TICKS;
+    bytes_config.flags.msb_first = 1;
+    rmt_copy_encoder_config_t copy_config = {};
+
+    esp_err_t err = rmt_new_bytes_encoder(&bytes_config, &enc->bytes);
+    if (err == ESP_OK) {
+        err = rmt_new_copy_encoder(&copy_config, &enc->copy);
+    }
+    if (err != ESP_OK) {
+        if (enc->bytes) {
+            rmt_del_encoder(enc->bytes);
+        }
+        free(enc);
+        return err;
+    }
+
+    enc->reset_code.level0 = 0;
+    enc->reset_code.duration0 = WS2812_RESET_TICKS / 2;
+    enc->reset_code.level1 = 0;
+    enc->reset_code.duration1 = WS2812_RESET_TICKS / 2;
+    *out = &enc->base;
+    return ESP_OK;
+}
+
+// Called from ISR context when a frame, reset code included, has gone out
+static bool IRAM_ATTR on_trans_done(rmt_channel_handle_t channel, const rmt_tx_done_event_data_t *edata,
+                                    void *user_ctx)
+{
+    ws2812_rmt *strip = (ws2812_rmt *)user_ctx;
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(strip->idle, &woken);
+    return woken == pdTRUE;
+}
+
+esp_err_t ws2812_rmt_new(const ws2812_rmt_config_t *config, ws2812_rmt_handle_t *out_handle)
+{
+    if (!config || !out_handle || config->led_count == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ws2812_rmt *strip = new (std::nothrow) ws2812_rmt();
+    size_t frame_bytes = (size_t)config->led_count * 3;
+    if (strip) {
+        strip->frame_bytes = frame_bytes;
+        strip->buffers[0] = (uint8_t *)calloc(2, frame_bytes);
+        strip->buffers[1] = strip->buffers[0] ? strip->buffers[0] + frame_bytes : NULL;
+        strip->idle = xSemaphoreCreateBinary();
+    }
+    if (!strip || !strip->buffers[0] || !strip->idle) {
+        ESP_LOGE(TAG, "Out of memory for %u LEDs", config->led_count);
+        ws2812_rmt_del(strip);
+        return ESP_ERR_NO_MEM;
+    }
+    xSemaphoreGive(strip->idle);
+
+    rmt_tx_channel_config_t channel_config = {};
+    channel_config.gpio_num = (gpio_num_t)config->gpio_num;
+    channel_config.clk_src = RMT_CLK_SRC_DEFAULT;
+    channel_config.resolution_hz = WS2812_RESOLUTION_HZ;
+    channel_config.mem_block_symbols = WS2812_MEM_SYMBOLS;
+    channel_config.trans_queue_depth = 2;
+
+    esp_err_t err = ESP_ERR_NOT_SUPPORTED;
+#if SOC_RMT_SUPPORT_DMA
+    channel_config.mem_block_symbols = WS2812_DMA_SYMBOLS;
+    channel_config.flags.with_dma = 1;
+    err = rmt_new_tx_channel(&channel_config, &strip->channel);
+    if (err != ESP_OK) {
+        channel_config.mem_block_symbols = WS2812_MEM_SYMBOLS;
+        channel_config.flags.with_dma = 0;
+    }
+#endif
+    if (err != ESP_OK) {
+        err = rmt_new_tx_channel(&channel_config, &strip->channel);
+    }
+    if (err == ESP_OK) {
+        err = new_ws2812_encoder(&strip->encoder);
+    }
+    if (err == ESP_OK) {
+        rmt_tx_event_callbacks_t callbacks = {};
+        callbacks.on_trans_done = on_trans_done;
+        err = rmt_tx_register_event_callbacks(strip->channel, &callbacks, strip);
+    }
+    if (err == ESP_OK) {
+        err = rmt_enable(strip->channel);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set up RMT on GPIO %d: %s", config->gpio_num, esp_err_to_name(err));
+        ws2812_rmt_del(strip);
+        return err;
+    }
+
+    ESP_LOGI(TAG, "%u LEDs on GPIO %d (%s)", config->led_count, config->gpio_num,
+             channel_config.flags.with_dma ? "DMA" : "interrupt refill");
+    *out_handle = strip;
+    return ESP_OK;
+}
+
+uint8_t *ws2812_rmt_back_buffer(ws2812_rmt_handle_t strip)
+{
+    return strip->buffers[strip->back];
+}
+
+esp_err_t ws2812_rmt_submit(ws2812_rmt_handle_t strip, uint32_t timeout_ms)
+{
+    // Normally the previous frame finished while this one was being written
+    if (xSemaphoreTake(strip->idle, 0) != pdTRUE) {
+        strip->busy_waits.fetch_add(1, std::memory_order_relaxed);
+        if (xSemaphoreTake(strip->idle, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+
+    rmt_transmit_config_t tx_config = {};
+    tx_config.loop_count = 0;
+    esp_err_t err = rmt_transmit(strip->channel, strip->encoder, strip->buffers[strip->back],
+                                 strip->frame_bytes, &tx_config);
+    if (err != ESP_OK) {
+        xSemaphoreGive(strip->idle);
+        return err;
+    }
+    // The other buffer's frame is out, so it is free to write
+    strip->back ^= 1;
+    return ESP_OK;
+}
+
+uint32_t ws2812_rmt_get_busy_waits(ws2812_rmt_handle_t strip)
+{
+    return strip->busy_waits.load(std::memory_order_relaxed);
+}
+
+void ws2812_rmt_del(ws2812_rmt_handle_t strip)
+{
+    if (!strip) {
+        return;
+    }
+    if (strip->channel) {
+        rmt_tx_wait_all_done(strip->channel, -1);
+        rmt_disable(strip->channel);
+        rmt_del_channel(strip->channel);
+    }
+    if (strip->encoder) {
+        rmt_del_encoder(strip->encoder);
+    }
+    if (strip->idle) {
+        vSemaphoreDelete(strip->idle);
+    }
+    free(strip->buffers[0]);
+    delete strip;
+}
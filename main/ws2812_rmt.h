@@ -0,0 +1,63 @@
+#pragma once
+
+#include <esp_err.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ws2812_rmt *ws2812_rmt_handle_t;
+
+typedef struct {
+    int gpio_num;         // Data line
+    uint16_t led_count;
+} ws2812_rmt_config_t;
+
+/**
+ * @brief Create a WS2812 transmitter on its own RMT TX channel
+ *
+ * Frames go out in the background: the channel uses DMA while the chip has
+ * a DMA-capable RMT channel free (SOC_RMT_SUPPORT_DMA), and is refilled
+ * from the RMT interrupt otherwise. Each transmitter owns two pixel
+ * buffers, so the next frame is written into one while the other is still
+ * on the wire.
+ *
+ * @param config Data GPIO and number of LEDs
+ * @param out_handle Receives the transmitter
+ * @return esp_err_t ESP_OK on success, otherwise error
+ */
+esp_err_t ws2812_rmt_new(const ws2812_rmt_config_t *config, ws2812_rmt_handle_t *out_handle);
+
+/**
+ * @brief Buffer for the next frame: 3 bytes per LED, in the strip's wire order
+ *
+ * Valid until the next ws2812_rmt_submit(); never the buffer being sent.
+ */
+uint8_t *ws2812_rmt_back_buffer(ws2812_rmt_handle_t strip);
+
+/**
+ * @brief Start sending the back buffer and swap buffers
+ *
+ * Returns as soon as the transmission is queued. Only waits (up to
+ * timeout_ms) if the previous frame is still going out, i.e. when frames
+ * are submitted faster than the strip can take them.
+ *
+ * @return esp_err_t ESP_OK, or ESP_ERR_TIMEOUT if the previous frame never finished
+ */
+esp_err_t ws2812_rmt_submit(ws2812_rmt_handle_t strip, uint32_t timeout_ms);
+
+/**
+ * @brief Submits that had to wait for the previous frame, since creation
+ */
+uint32_t ws2812_rmt_get_busy_waits(ws2812_rmt_handle_t strip);
+
+/**
+ * @brief Wait for the frame on the wire and release the channel and buffers
+ */
+void ws2812_rmt_del(ws2812_rmt_handle_t strip);
+
+#ifdef __cplusplus
+}
+#endif